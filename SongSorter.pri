@@ -0,0 +1,59 @@
+# The sources shared by the application and the tests.
+
+SOURCES += \
+    $$PWD/mediaHandling/analysisstore.cpp \
+    $$PWD/mediaHandling/artworkcache.cpp \
+    $$PWD/mediaHandling/audioanalyzer.cpp \
+    $$PWD/mediaHandling/loudnessmeter.cpp \
+    $$PWD/mediaHandling/previewsegmentdetector.cpp \
+    $$PWD/songHandling/directorytraverser.cpp \
+    $$PWD/songHandling/ioscheduler.cpp \
+    $$PWD/songHandling/namenormalizer.cpp \
+    $$PWD/songHandling/playlistparser.cpp \
+    $$PWD/songHandling/song.cpp \
+    $$PWD/songHandling/songbatch.cpp \
+    $$PWD/songHandling/songlistsorter.cpp \
+    $$PWD/songHandling/tagreader.cpp \
+    $$PWD/songHandling/tagworkerpool.cpp \
+    $$PWD/songHandling/tagwriter.cpp \
+    $$PWD/sorting/preferencestore.cpp \
+    $$PWD/sorting/rankingengine.cpp \
+    $$PWD/UI/startupwindow.cpp \
+    $$PWD/UI/comparisonwindow.cpp \
+    $$PWD/UI/songlistmodel.cpp \
+    $$PWD/UI/songlistviewerwindow.cpp
+
+HEADERS += \
+    $$PWD/mediaHandling/analysisstore.h \
+    $$PWD/mediaHandling/artworkcache.h \
+    $$PWD/mediaHandling/audioanalyzer.h \
+    $$PWD/mediaHandling/loudnessmeter.h \
+    $$PWD/mediaHandling/previewsegmentdetector.h \
+    $$PWD/songHandling/directorytraverser.h \
+    $$PWD/songHandling/ioscheduler.h \
+    $$PWD/songHandling/namenormalizer.h \
+    $$PWD/songHandling/playlistparser.h \
+    $$PWD/songHandling/song.h \
+    $$PWD/songHandling/songbatch.h \
+    $$PWD/songHandling/songlistsorter.h \
+    $$PWD/songHandling/tagreader.h \
+    $$PWD/songHandling/tagworkerpool.h \
+    $$PWD/songHandling/tagwriter.h \
+    $$PWD/sorting/preferencestore.h \
+    $$PWD/sorting/rankingengine.h \
+    $$PWD/UI/startupwindow.h \
+    $$PWD/UI/comparisonwindow.h \
+    $$PWD/UI/songlistmodel.h \
+    $$PWD/UI/songlistviewerwindow.h
+
+
+FORMS += \
+    $$PWD/UI/comparisonwindow.ui \
+    $$PWD/UI/startupwindow.ui \
+    $$PWD/UI/songlistviewerwindow.ui
+
+win32: LIBS += -L$$PWD/taglib/lib/ -llibtag.dll
+unix: LIBS += -ltag
+
+INCLUDEPATH += $$PWD $$PWD/taglib/include
+DEPENDPATH += $$PWD/taglib/include
@@ -6,7 +6,21 @@
   @brief Contains the UI handling for the comparison window.
   @ingroup UI
 
-  This class handles the various UI events that can occur on the comparison window.
+  This class handles the various UI events that can occur on the comparison window. The window asks
+  the @link RankingEngine ranking engine@endlink for the next group of songs and shows it in one of
+  two @link ComparisonWindow::COMPARISON_MODE modes@endlink: a pair of buttons when comparing two songs,
+  or a list that can be reordered by dragging when comparing a batch of songs.
+
+  When comparing pairs, the engine is asked what the next pair would be for both answers while the user is
+  still deciding. The text and artwork of both pairs are prepared then, so whichever song is picked, the next
+  pair is shown without waiting on anything.
+
+  Every answer is kept in the @link PreferenceStore preference store@endlink when the sort ends. Groups whose order
+  is already known from earlier sorts are answered without being shown, so sorting an overlapping set of songs
+  only asks about the pairs that haven't been settled before.
+
+  Songs can be sorted within their album or artist first, in which case the user compares the songs of one
+  group until it's finished before the groups are merged into the full ranking.
 */
 
 //-----------------------------------------------
@@ -22,6 +36,17 @@ ComparisonWindow::ComparisonWindow(QWidget *parent) :
     ui(new Ui::ComparisonWindow)
 {
     ui->setupUi(this);
+    ui->leftSongButton->setIconSize(QSize(200, 200));
+    ui->rightSongButton->setIconSize(QSize(200, 200));
+    ui->batchListWidget->setIconSize(QSize(64, 64));
+    ui->undoButton->setShortcut(QKeySequence(QKeySequence::Undo));
+
+    mArtworkCache = new ArtworkCache(this);
+    connect(mArtworkCache, SIGNAL(artworkReady(QString,QImage)), this, SLOT(on_artworkReady(QString,QImage)));
+
+    mPreviewPlayer = new QMediaPlayer(this);
+    connect(mPreviewPlayer, SIGNAL(mediaStatusChanged(QMediaPlayer::MediaStatus)), this, SLOT(on_previewMediaStatusChanged(QMediaPlayer::MediaStatus)));
+    connect(mPreviewPlayer, SIGNAL(positionChanged(qint64)), this, SLOT(on_previewPositionChanged(qint64)));
 }
 
 /**
@@ -31,3 +56,623 @@ ComparisonWindow::~ComparisonWindow()
 {
     delete ui;
 }
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Sets the analyzer that provides the gain for previews.
+ * @param aAudioAnalyzer The analyzer. Previews are played without volume matching if it's null.
+ */
+void ComparisonWindow::setAudioAnalyzer(AudioAnalyzer* aAudioAnalyzer)
+{
+    mAudioAnalyzer = aAudioAnalyzer;
+}
+
+/**
+ * @brief Sets the store that answers are reused from and saved to.
+ * @param aPreferenceStore The store. Every group is shown to the user and nothing is saved if it's null.
+ */
+void ComparisonWindow::setPreferenceStore(PreferenceStore* aPreferenceStore)
+{
+    mPreferenceStore = aPreferenceStore;
+}
+
+/**
+ * @brief Sets up the ComparisonWindow to sort a list of songs.
+ * @param aSongList The list of @link Song songs@endlink to sort. It is reordered by rank once the sort is finished.
+ * @param aBatchSize The number of songs to show at once. A batch size of 2 shows pairs of songs.
+ * @param aGrouping What the songs are grouped by before they're sorted, if anything.
+ *
+ * If some of the songs were ranked by an earlier sort and others weren't, the unranked songs are inserted into
+ * the existing ranking instead of sorting every song again, and the grouping isn't used. Otherwise, every song is
+ * sorted from scratch.
+ */
+void ComparisonWindow::setupComparisonWindow(QList<Song*>* aSongList, int aBatchSize, SORT_GROUPING aGrouping)
+{
+    mSongList = aSongList;
+
+    // Collect the songs that are already ranked, in rank order.
+    QVector<int> ranking;
+    for(int i = 0; i < mSongList->count(); i++)
+    {
+        if((*mSongList)[i]->getRank() != UNRANKED)
+        {
+            ranking.append(i);
+        }
+    }
+    if(!ranking.isEmpty() && ranking.count() < mSongList->count())
+    {
+        std::sort(ranking.begin(), ranking.end(), [this](int aFirst, int aSecond)
+        {
+            return (*mSongList)[aFirst]->getRank() < (*mSongList)[aSecond]->getRank();
+        });
+        mRankingEngine.resetWithRanking(ranking, mSongList->count(), aBatchSize);
+    }
+    else if(aGrouping != NO_GROUPING)
+    {
+        mRankingEngine.resetWithGroups(groupSongs(aGrouping), mSongList->count(), aBatchSize);
+    }
+    else
+    {
+        mRankingEngine.reset(mSongList->count(), aBatchSize);
+    }
+    mComparisonMode = (mRankingEngine.getBatchSize() == PAIRWISE_BATCH_SIZE) ? PAIRWISE : BATCH;
+
+    // Look up what earlier sorts know about these songs.
+    mKnownPreferences.clear();
+    mReusedDecisions.clear();
+    mSubmittedOrderings.clear();
+    if(mPreferenceStore != nullptr)
+    {
+        QVector<quint64> songKeys;
+        songKeys.reserve(mSongList->count());
+        for(const Song* song : *mSongList)
+        {
+            songKeys.append(PreferenceStore::getSongKey(song));
+        }
+        mKnownPreferences = mPreferenceStore->getPreferences(songKeys);
+    }
+
+    // Only show the widgets for the current mode.
+    bool pairwise = (mComparisonMode == PAIRWISE);
+    ui->leftSongButton->setVisible(pairwise);
+    ui->rightSongButton->setVisible(pairwise);
+    ui->leftPreviewButton->setVisible(pairwise);
+    ui->rightPreviewButton->setVisible(pairwise);
+    ui->batchListWidget->setVisible(!pairwise);
+    ui->confirmOrderButton->setVisible(!pairwise);
+
+    showNextGroup();
+}
+
+//-----------------------------------------------
+// Slots
+//-----------------------------------------------
+
+/**
+ * @brief Overrides the closeEvent from the QMainWindow parent class.
+ * @param event The close event.
+ *
+ * Closing the window before the sort is finished cancels the sort.
+ */
+void ComparisonWindow::closeEvent(QCloseEvent *event)
+{
+    mPreviewPlayer->stop();
+    mPreparedGroups.clear();
+    if(mSongList != nullptr)
+    {
+        saveJudgments();
+        mSongList = nullptr;
+        emit sortingCancelled();
+    }
+    event->accept();
+}
+
+/**
+ * @brief Handles the artwork of an album being loaded.
+ * @param aAlbumKey The @link ArtworkCache::getAlbumKey key@endlink of the album.
+ * @param aThumbnail The thumbnail of the album's artwork.
+ *
+ * The artwork is shown for every song in the current group that belongs to the album, and is added to the
+ * prepared groups.
+ */
+void ComparisonWindow::on_artworkReady(QString aAlbumKey, QImage aThumbnail)
+{
+    if(mSongList == nullptr)
+    {
+        return;
+    }
+    for(int i = 0; i < mCurrentGroup.items.count(); i++)
+    {
+        if(ArtworkCache::getAlbumKey((*mSongList)[mCurrentGroup.items[i]]) == aAlbumKey)
+        {
+            setArtwork(i, aThumbnail);
+        }
+    }
+    if(aThumbnail.isNull())
+    {
+        return;
+    }
+    for(prepared_group& preparedGroup : mPreparedGroups)
+    {
+        for(int i = 0; i < preparedGroup.group.items.count(); i++)
+        {
+            if(ArtworkCache::getAlbumKey((*mSongList)[preparedGroup.group.items[i]]) == aAlbumKey)
+            {
+                preparedGroup.icons[i] = QIcon(QPixmap::fromImage(aThumbnail));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Handles a song in the batch list being double clicked.
+ * @param item The list item of the song.
+ *
+ * Double clicking a song plays a preview of it.
+ */
+void ComparisonWindow::on_batchListWidget_itemDoubleClicked(QListWidgetItem* item)
+{
+    playPreview(item->data(Qt::UserRole).toInt());
+}
+
+/**
+ * @brief Handles the Confirm Order button being clicked and released.
+ *
+ * The order of the songs in the batch list, from top to bottom, is submitted as the user's ordering
+ * from favorite to least favorite.
+ */
+void ComparisonWindow::on_confirmOrderButton_released()
+{
+    QVector<int> orderedItems;
+    for(int row = 0; row < ui->batchListWidget->count(); row++)
+    {
+        orderedItems.append(ui->batchListWidget->item(row)->data(Qt::UserRole).toInt());
+    }
+    submitOrdering(orderedItems);
+}
+
+/**
+ * @brief Handles the Preview button under the song on the left being clicked and released.
+ */
+void ComparisonWindow::on_leftPreviewButton_released()
+{
+    playPreview(mCurrentGroup.items.first());
+}
+
+/**
+ * @brief Handles the song on the left being chosen.
+ */
+void ComparisonWindow::on_leftSongButton_released()
+{
+    submitOrdering(mCurrentGroup.items);
+}
+
+/**
+ * @brief Handles the status of the preview's media changing.
+ * @param aStatus The new status.
+ *
+ * Seeking only works once the media is loaded, so the preview jumps to its segment here.
+ */
+void ComparisonWindow::on_previewMediaStatusChanged(QMediaPlayer::MediaStatus aStatus)
+{
+    if(aStatus == QMediaPlayer::LoadedMedia && mPreviewStart > 0)
+    {
+        mPreviewPlayer->setPosition(mPreviewStart);
+    }
+}
+
+/**
+ * @brief Handles the position of the preview changing.
+ * @param aPosition The new position in ms.
+ *
+ * The preview stops at the end of its segment.
+ */
+void ComparisonWindow::on_previewPositionChanged(qint64 aPosition)
+{
+    if(mPreviewEnd >= 0 && aPosition >= mPreviewEnd)
+    {
+        mPreviewPlayer->stop();
+    }
+}
+
+/**
+ * @brief Handles the Preview button under the song on the right being clicked and released.
+ */
+void ComparisonWindow::on_rightPreviewButton_released()
+{
+    playPreview(mCurrentGroup.items.last());
+}
+
+/**
+ * @brief Handles the song on the right being chosen.
+ */
+void ComparisonWindow::on_rightSongButton_released()
+{
+    submitOrdering(QVector<int>() << mCurrentGroup.items.last() << mCurrentGroup.items.first());
+}
+
+/**
+ * @brief Handles the Undo button being clicked and released.
+ *
+ * The last answer is taken back and the group of songs that it answered is shown again. Answers reused from
+ * earlier sorts since then would just be given again, so they're taken back along with it.
+ */
+void ComparisonWindow::on_undoButton_released()
+{
+    int lastUserDecision = mReusedDecisions.lastIndexOf(false);
+    if(lastUserDecision < 0)
+    {
+        return;
+    }
+    mRankingEngine.undo(mReusedDecisions.count() - lastUserDecision);
+    mReusedDecisions.resize(lastUserDecision);
+    mSubmittedOrderings.removeLast();
+    showNextGroup();
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Gets the text that is shown for a song.
+ * @param aItem The index of the song in the song list.
+ * @return The song name, artist, and album of the song.
+ */
+QString ComparisonWindow::describeSong(int aItem) const
+{
+    const Song* song = (*mSongList)[aItem];
+    return QString("%1\n%2\n%3").arg(song->getSongName(), song->getArtistName(), song->getAlbumName());
+}
+
+/**
+ * @brief Ranks the songs using the result of the sort and reorders the song list by rank.
+ */
+void ComparisonWindow::finishSorting()
+{
+    mPreviewPlayer->stop();
+    mPreparedGroups.clear();
+    saveJudgments();
+    QVector<int> ranking = mRankingEngine.getRanking();
+    QList<Song*> rankedSongs;
+    for(int i = 0; i < ranking.count(); i++)
+    {
+        Song* song = (*mSongList)[ranking[i]];
+        song->setRank(i + 1);
+        rankedSongs.append(song);
+    }
+    *mSongList = rankedSongs;
+
+    // The song list is shared, so we just let go of it.
+    mSongList = nullptr;
+    emit sortingFinished();
+    close();
+}
+
+/**
+ * @brief Works out the order of a group of songs from the answers of earlier sorts.
+ * @param aItems The songs in the group.
+ * @param aOrdering Set to the songs ordered from favorite to least favorite if the order is known.
+ * @return True if every pair in the group has a known answer and the answers agree on a single order.
+ */
+bool ComparisonWindow::getKnownOrdering(const QVector<int>& aItems, QVector<int>* aOrdering) const
+{
+    if(mKnownPreferences.isEmpty())
+    {
+        return false;
+    }
+
+    // Count how many songs in the group each song beats.
+    QVector<int> numWins(aItems.count(), 0);
+    for(int i = 0; i < aItems.count(); i++)
+    {
+        for(int j = i + 1; j < aItems.count(); j++)
+        {
+            QPair<int, int> pair(qMin(aItems[i], aItems[j]), qMax(aItems[i], aItems[j]));
+            QHash<QPair<int, int>, bool>::const_iterator iter = mKnownPreferences.constFind(pair);
+            if(iter == mKnownPreferences.constEnd())
+            {
+                return false;
+            }
+            bool firstPreferred = (*iter == (aItems[i] == pair.first));
+            numWins[firstPreferred ? i : j]++;
+        }
+    }
+
+    // The answers agree on a single order only if no two songs beat the same number of songs.
+    QVector<int> ordering(aItems.count(), -1);
+    for(int i = 0; i < aItems.count(); i++)
+    {
+        int position = aItems.count() - 1 - numWins[i];
+        if(ordering[position] >= 0)
+        {
+            return false;
+        }
+        ordering[position] = aItems[i];
+    }
+    *aOrdering = ordering;
+    return true;
+}
+
+/**
+ * @brief Groups the songs being sorted by album or by artist.
+ * @param aGrouping What the songs are grouped by.
+ * @return The indices of the songs in each group. Groups are in the order that their first song is in the song list.
+ * Songs without an album or an artist aren't in a group.
+ *
+ * Names are @link NameNormalizer normalized@endlink first, so spelling differences don't split a group.
+ */
+QList<QVector<int>> ComparisonWindow::groupSongs(SORT_GROUPING aGrouping) const
+{
+    NameNormalizer normalizer;
+    QHash<int, int> groupIndices;
+    QList<QVector<int>> groups;
+    for(int i = 0; i < mSongList->count(); i++)
+    {
+        const Song* song = (*mSongList)[i];
+        int key = (aGrouping == ARTIST_GROUPING) ? normalizer.getArtistKey(song) : normalizer.getAlbumKey(song);
+        if(key == NO_GROUP_KEY)
+        {
+            continue;
+        }
+        if(!groupIndices.contains(key))
+        {
+            groupIndices.insert(key, groups.count());
+            groups.append(QVector<int>());
+        }
+        groups[groupIndices.value(key)].append(i);
+    }
+    return groups;
+}
+
+/**
+ * @brief Plays a preview of a song.
+ * @param aItem The index of the song in the song list.
+ *
+ * If the song has been analyzed, its ReplayGain is applied so that louder masters don't sound better
+ * just because they're louder, and only its most representative segment is played.
+ */
+void ComparisonWindow::playPreview(int aItem)
+{
+    const Song* song = (*mSongList)[aItem];
+    double gain = 0.0;
+    mPreviewStart = 0;
+    mPreviewEnd = -1;
+    AnalysisStore::audio_analysis analysis;
+    if(mAudioAnalyzer != nullptr && mAudioAnalyzer->getAnalysis(song->getFilePath(), &analysis))
+    {
+        gain = analysis.replay_gain;
+        if(analysis.preview_length > 0)
+        {
+            mPreviewStart = analysis.preview_start;
+            mPreviewEnd = analysis.preview_start + analysis.preview_length;
+        }
+    }
+
+    double volume = qBound(0.0, PREVIEW_VOLUME * qPow(10.0, gain / 20.0), 1.0);
+    mPreviewPlayer->setMedia(QUrl::fromLocalFile(song->getFilePath()));
+    mPreviewPlayer->setVolume(qRound(volume * 100));
+    mPreviewPlayer->play();
+}
+
+/**
+ * @brief Prepares the pairs that can follow the current pair, one for each song winning.
+ *
+ * This runs after the current pair is shown, so it doesn't hold up the pair. Artwork that isn't loaded yet
+ * is requested so that it's ready by the time the next pair is shown.
+ */
+void ComparisonWindow::prepareSuccessorGroups()
+{
+    if(mSongList == nullptr || mComparisonMode != PAIRWISE || !mPreparedGroups.isEmpty() || mCurrentGroup.items.count() != PAIRWISE_BATCH_SIZE)
+    {
+        return;
+    }
+
+    QList<QVector<int>> answers;
+    answers.append(mCurrentGroup.items);
+    answers.append(QVector<int>() << mCurrentGroup.items.last() << mCurrentGroup.items.first());
+    QList<const Song*> upcomingSongs;
+    for(const QVector<int>& answer : answers)
+    {
+        prepared_group preparedGroup;
+        preparedGroup.group = mRankingEngine.predictNextGroup(mCurrentGroup.task_id, answer);
+        for(int item : preparedGroup.group.items)
+        {
+            const Song* song = (*mSongList)[item];
+            QImage thumbnail = mArtworkCache->getCachedArtwork(song);
+            preparedGroup.descriptions.append(describeSong(item));
+            preparedGroup.icons.append(thumbnail.isNull() ? QIcon() : QIcon(QPixmap::fromImage(thumbnail)));
+            upcomingSongs.append(song);
+        }
+        mPreparedGroups.append(preparedGroup);
+    }
+    mArtworkCache->prefetchArtwork(upcomingSongs);
+}
+
+/**
+ * @brief Adds the user's answers from this sort to the preference store.
+ *
+ * The user ordered every song in each submitted group, so each pair in the group is saved as a judgment.
+ */
+void ComparisonWindow::saveJudgments()
+{
+    if(mPreferenceStore != nullptr && !mSubmittedOrderings.isEmpty())
+    {
+        QList<QPair<quint64, quint64>> judgments;
+        for(const QVector<int>& ordering : mSubmittedOrderings)
+        {
+            QVector<quint64> songKeys;
+            for(int item : ordering)
+            {
+                songKeys.append(PreferenceStore::getSongKey((*mSongList)[item]));
+            }
+            for(int i = 0; i < songKeys.count(); i++)
+            {
+                for(int j = i + 1; j < songKeys.count(); j++)
+                {
+                    judgments.append(qMakePair(songKeys[i], songKeys[j]));
+                }
+            }
+        }
+        mPreferenceStore->addJudgments(judgments);
+        mPreferenceStore->save();
+    }
+    mSubmittedOrderings.clear();
+}
+
+/**
+ * @brief Shows the artwork of a song in the current group.
+ * @param aIndexInGroup The index of the song in the current group.
+ * @param aIcon The artwork of the song's album. A null icon clears the artwork.
+ */
+void ComparisonWindow::setArtwork(int aIndexInGroup, const QIcon& aIcon)
+{
+    if(mComparisonMode == PAIRWISE)
+    {
+        QPushButton* songButton = (aIndexInGroup == 0) ? ui->leftSongButton : ui->rightSongButton;
+        songButton->setIcon(aIcon);
+    }
+    else
+    {
+        // Items in the batch list can be dragged around, so find the item by its song.
+        for(int row = 0; row < ui->batchListWidget->count(); row++)
+        {
+            QListWidgetItem* listItem = ui->batchListWidget->item(row);
+            if(listItem->data(Qt::UserRole).toInt() == mCurrentGroup.items[aIndexInGroup])
+            {
+                listItem->setIcon(aIcon);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Shows the artwork of a song in the current group.
+ * @param aIndexInGroup The index of the song in the current group.
+ * @param aThumbnail The thumbnail of the song's album. A null image clears the artwork.
+ */
+void ComparisonWindow::setArtwork(int aIndexInGroup, const QImage& aThumbnail)
+{
+    setArtwork(aIndexInGroup, aThumbnail.isNull() ? QIcon() : QIcon(QPixmap::fromImage(aThumbnail)));
+}
+
+/**
+ * @brief Shows the next group of songs from the ranking engine, or finishes the sort if there isn't one.
+ *
+ * If the group was prepared ahead of time, its text and artwork are used as is. Otherwise, the artwork of
+ * the songs in the group is shown once it's loaded. Either way, the groups that can come up next are
+ * prepared once this group is on screen. The progress label shows how many comparisons have been made and
+ * the range of how many are left.
+ *
+ * Groups whose order is known from earlier sorts are answered first, without being shown.
+ */
+void ComparisonWindow::showNextGroup()
+{
+    RankingEngine::comparison_group nextGroup = mRankingEngine.getNextGroup();
+    QVector<int> knownOrdering;
+    while(!nextGroup.items.isEmpty() && getKnownOrdering(nextGroup.items, &knownOrdering))
+    {
+        mRankingEngine.submitOrdering(nextGroup.task_id, knownOrdering);
+        mReusedDecisions.append(true);
+        nextGroup = mRankingEngine.getNextGroup();
+    }
+
+    if(mRankingEngine.isFinished())
+    {
+        finishSorting();
+        return;
+    }
+
+    mPreviewPlayer->stop();
+    mCurrentGroup = nextGroup;
+
+    // Use the prepared group if the engine came up with the group that was expected.
+    prepared_group preparedGroup;
+    for(const prepared_group& candidate : mPreparedGroups)
+    {
+        if(candidate.group.task_id == mCurrentGroup.task_id && candidate.group.items == mCurrentGroup.items)
+        {
+            preparedGroup = candidate;
+            break;
+        }
+    }
+    mPreparedGroups.clear();
+
+    if(mComparisonMode == PAIRWISE)
+    {
+        bool isPrepared = !preparedGroup.descriptions.isEmpty();
+        ui->instructionLabel->setText("Which song do you like more?");
+        ui->leftSongButton->setText(isPrepared ? preparedGroup.descriptions.first() : describeSong(mCurrentGroup.items.first()));
+        ui->rightSongButton->setText(isPrepared ? preparedGroup.descriptions.last() : describeSong(mCurrentGroup.items.last()));
+    }
+    else
+    {
+        ui->instructionLabel->setText("Drag the songs into order from favorite to least favorite. Double click a song to preview it.");
+        ui->batchListWidget->clear();
+        for(int item : mCurrentGroup.items)
+        {
+            QListWidgetItem* listItem = new QListWidgetItem(describeSong(item), ui->batchListWidget);
+            listItem->setData(Qt::UserRole, item);
+        }
+    }
+
+    // Show the artwork that is already loaded and request the rest.
+    for(int i = 0; i < mCurrentGroup.items.count(); i++)
+    {
+        if(i < preparedGroup.icons.count() && !preparedGroup.icons[i].isNull())
+        {
+            setArtwork(i, preparedGroup.icons[i]);
+            continue;
+        }
+        const Song* song = (*mSongList)[mCurrentGroup.items[i]];
+        QImage thumbnail = mArtworkCache->getCachedArtwork(song);
+        setArtwork(i, thumbnail);
+        if(thumbnail.isNull())
+        {
+            mArtworkCache->requestArtwork(song);
+        }
+    }
+    if(mComparisonMode == PAIRWISE)
+    {
+        QTimer::singleShot(0, this, &ComparisonWindow::prepareSuccessorGroups);
+    }
+    else
+    {
+        QList<const Song*> upcomingSongs;
+        for(int item : mRankingEngine.getUpcomingItems())
+        {
+            upcomingSongs.append((*mSongList)[item]);
+        }
+        mArtworkCache->prefetchArtwork(upcomingSongs);
+    }
+    // The engine keeps its bounds up to date as it goes, so reading them doesn't slow down each answer.
+    int lowerBound = 0;
+    int upperBound = 0;
+    mRankingEngine.getRemainingInteractions(&lowerBound, &upperBound);
+    QString remaining = (lowerBound == upperBound) ? QString::number(lowerBound) : QString("%1 to %2").arg(lowerBound).arg(upperBound);
+    QString progress = QString("Comparisons made: %1    Comparisons left: %2").arg(mReusedDecisions.count(false)).arg(remaining);
+    int numReused = mReusedDecisions.count(true);
+    if(numReused > 0)
+    {
+        progress += QString("    Answered by earlier sorts: %1").arg(numReused);
+    }
+    ui->progressLabel->setText(progress);
+    ui->undoButton->setEnabled(mReusedDecisions.contains(false));
+}
+
+/**
+ * @brief Submits the user's ordering of the current group and moves on to the next group.
+ * @param aOrderedItems The songs in the current group, ordered from favorite to least favorite.
+ */
+void ComparisonWindow::submitOrdering(const QVector<int>& aOrderedItems)
+{
+    if(mRankingEngine.submitOrdering(mCurrentGroup.task_id, aOrderedItems))
+    {
+        mReusedDecisions.append(false);
+        mSubmittedOrderings.append(aOrderedItems);
+    }
+    showNextGroup();
+}
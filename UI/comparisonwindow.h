@@ -1,7 +1,31 @@
 #ifndef SORTINGWINDOW_H
 #define SORTINGWINDOW_H
 
+#include <algorithm>
+#include <QCloseEvent>
+#include <QHash>
+#include <QIcon>
+#include <QImage>
+#include <QKeySequence>
+#include <QList>
+#include <QListWidgetItem>
 #include <QMainWindow>
+#include <QMediaPlayer>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QtMath>
+#include <QUrl>
+#include <QVector>
+#include "mediaHandling/artworkcache.h"
+#include "mediaHandling/audioanalyzer.h"
+#include "songHandling/namenormalizer.h"
+#include "songHandling/song.h"
+#include "sorting/preferencestore.h"
+#include "sorting/rankingengine.h"
+
+#define PREVIEW_VOLUME 0.5
 
 namespace Ui {
     class ComparisonWindow;
@@ -12,11 +36,88 @@ class ComparisonWindow : public QMainWindow
         Q_OBJECT
 
     public:
+        /**
+         * @brief The different ways that songs can be presented for comparison.
+         */
+        typedef enum COMPARISON_MODE
+        {
+            PAIRWISE, //!< Two songs are shown and the user picks the one they like more.
+            BATCH //!< A group of songs is shown and the user drags them into order.
+        } COMPARISON_MODE;
+
+        /**
+         * @brief What songs are grouped by, so that each group is sorted on its own before the groups are merged.
+         */
+        typedef enum SORT_GROUPING
+        {
+            NO_GROUPING, //!< Every song is sorted together.
+            ALBUM_GROUPING, //!< The songs of each album are sorted together first.
+            ARTIST_GROUPING //!< The songs of each artist are sorted together first.
+        } SORT_GROUPING;
+
         explicit ComparisonWindow(QWidget *parent = 0);
         ~ComparisonWindow();
 
+        void setAudioAnalyzer(AudioAnalyzer* aAudioAnalyzer);
+        void setPreferenceStore(PreferenceStore* aPreferenceStore);
+        void setupComparisonWindow(QList<Song*>* aSongList, int aBatchSize, SORT_GROUPING aGrouping = NO_GROUPING);
+
+    signals:
+        void sortingCancelled(); //!< Emitted when the window is closed before the sort is finished.
+        void sortingFinished(); //!< Emitted when every song has been ranked and the song list is in rank order.
+
+    private slots:
+        void closeEvent(QCloseEvent *event);
+        void on_artworkReady(QString aAlbumKey, QImage aThumbnail);
+        void on_batchListWidget_itemDoubleClicked(QListWidgetItem* item);
+        void on_confirmOrderButton_released();
+        void on_leftPreviewButton_released();
+        void on_leftSongButton_released();
+        void on_previewMediaStatusChanged(QMediaPlayer::MediaStatus aStatus);
+        void on_previewPositionChanged(qint64 aPosition);
+        void on_rightPreviewButton_released();
+        void on_rightSongButton_released();
+        void on_undoButton_released();
+
     private:
+        /**
+         * @brief A group of songs that may be shown next, prepared while the user decides on the current group.
+         */
+        typedef struct prepared_group
+        {
+            RankingEngine::comparison_group group; //!< The group that the engine would return.
+            QStringList descriptions; //!< The text of each song in the group.
+            QList<QIcon> icons; //!< The artwork of each song in the group. Null if it wasn't loaded when the group was prepared.
+        } prepared_group;
+
+        QString describeSong(int aItem) const;
+        void finishSorting();
+        bool getKnownOrdering(const QVector<int>& aItems, QVector<int>* aOrdering) const;
+        QList<QVector<int>> groupSongs(SORT_GROUPING aGrouping) const;
+        void playPreview(int aItem);
+        void prepareSuccessorGroups();
+        void saveJudgments();
+        void setArtwork(int aIndexInGroup, const QIcon& aIcon);
+        void setArtwork(int aIndexInGroup, const QImage& aThumbnail);
+        void showNextGroup();
+        void submitOrdering(const QVector<int>& aOrderedItems);
+
         Ui::ComparisonWindow *ui; //!< The ui for the ComparisonWindow.
+
+        ArtworkCache* mArtworkCache = nullptr; //!< Loads the album artwork that is shown next to each song.
+        AudioAnalyzer* mAudioAnalyzer = nullptr; //!< Provides the gain that volume-matches previews. Owned by the StartupWindow.
+        COMPARISON_MODE mComparisonMode = PAIRWISE; //!< The \link COMPARISON_MODE mode\endlink that the window is in.
+        RankingEngine::comparison_group mCurrentGroup; //!< The group of songs that is currently shown to the user.
+        QHash<QPair<int, int>, bool> mKnownPreferences; //!< The answers from earlier sorts, keyed by pairs of songs with the smaller index first. True if that song is preferred.
+        PreferenceStore* mPreferenceStore = nullptr; //!< Keeps the user's answers across sorts. Owned by the StartupWindow.
+        QList<prepared_group> mPreparedGroups; //!< The groups that can follow the current group, one for each answer. Empty until they've been prepared.
+        qint64 mPreviewEnd = -1; //!< Where the preview that is playing should stop, in ms. -1 to play to the end of the song.
+        QMediaPlayer* mPreviewPlayer = nullptr; //!< Plays previews of the songs being compared.
+        qint64 mPreviewStart = 0; //!< Where the preview that is playing should start, in ms.
+        RankingEngine mRankingEngine; //!< The engine that decides which songs to compare.
+        QVector<bool> mReusedDecisions; //!< For each decision that the engine has journaled, whether it was answered from earlier sorts instead of by the user.
+        QList<Song*>* mSongList = nullptr; //!< The list of \link Song songs\endlink being sorted. Items in the engine are indices into this list.
+        QList<QVector<int>> mSubmittedOrderings; //!< The orderings that the user has submitted, which are added to the preference store when the sort ends.
 };
 
 #endif // SORTINGWINDOW_H
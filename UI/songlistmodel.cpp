@@ -0,0 +1,178 @@
+#include "songlistmodel.h"
+
+#include "UI/songlistviewerwindow.h"
+
+/**
+  @class SongListModel
+  @ingroup UI
+  @brief Shows the results of a sort in a table view.
+
+  The model doesn't copy anything from the @link Song songs@endlink. Each cell is read from its Song when the
+  view paints it, so only the rows on screen cost anything, however long the list is.
+
+  The rows are shown in a @link SongListModel::setDisplayOrder display order@endlink. Changing it only moves
+  the rows, so re-sorting the results doesn't create or destroy anything. The selection stays on the same songs.
+*/
+
+//-----------------------------------------------
+// Constructors and Destructor
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for the SongListModel.
+ * @param parent The parent of the model.
+ */
+SongListModel::SongListModel(QObject *parent) :
+    QAbstractTableModel(parent)
+{}
+
+/**
+ * @brief Destructor for the SongListModel.
+ */
+SongListModel::~SongListModel()
+{}
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Gets the number of columns.
+ * @param aParent The parent of the columns. Only the root has columns.
+ * @return The number of columns.
+ */
+int SongListModel::columnCount(const QModelIndex& aParent) const
+{
+    return aParent.isValid() ? 0 : SONG_LIST_MODEL_NUM_COLUMNS;
+}
+
+/**
+ * @brief Gets what is shown in a cell.
+ * @param aIndex The cell.
+ * @param aRole What is being asked for.
+ * @return The text of the cell for the display role, and its alignment for the alignment role.
+ */
+QVariant SongListModel::data(const QModelIndex& aIndex, int aRole) const
+{
+    if(!aIndex.isValid() || mSongList == nullptr || aIndex.row() >= mDisplayOrder.count() || mDisplayOrder[aIndex.row()] >= mSongList->count())
+    {
+        return QVariant();
+    }
+
+    const Song* song = (*mSongList)[mDisplayOrder[aIndex.row()]];
+    if(aRole == Qt::DisplayRole)
+    {
+        switch(aIndex.column())
+        {
+            case CHECKBOX_OR_RANK_COLUMN:
+                return QString("%1").arg(song->getRank());
+            case ARTIST_COLUMN:
+                return song->getArtistName();
+            case ALBUM_COLUMN:
+                return song->getAlbumName();
+            case TRACK_NUMBER_COLUMN:
+                return QString("%1").arg(song->getTrackNumber());
+            case SONG_NAME_COLUMN:
+                return song->getSongName();
+            default:
+                Q_ASSERT_X(false, "SongListModel::data", "Reached default case when we shouldn't have!");
+                break;
+        }
+    }
+    else if(aRole == Qt::TextAlignmentRole && aIndex.column() != CHECKBOX_OR_RANK_COLUMN)
+    {
+        return (int)(Qt::AlignHCenter | Qt::AlignVCenter);
+    }
+    return QVariant();
+}
+
+/**
+ * @brief Gets what is shown in a header.
+ * @param aSection The column or row of the header.
+ * @param aOrientation Whether it's a column header or a row header.
+ * @param aRole What is being asked for.
+ * @return The name of the column for column headers. Row headers use the default.
+ */
+QVariant SongListModel::headerData(int aSection, Qt::Orientation aOrientation, int aRole) const
+{
+    if(aOrientation == Qt::Horizontal && aRole == Qt::DisplayRole)
+    {
+        switch(aSection)
+        {
+            case CHECKBOX_OR_RANK_COLUMN:
+                return QString("Rank");
+            case ARTIST_COLUMN:
+                return QString("Artist");
+            case ALBUM_COLUMN:
+                return QString("Album");
+            case TRACK_NUMBER_COLUMN:
+                return QString("Track");
+            case SONG_NAME_COLUMN:
+                return QString("Song Name");
+            default:
+                break;
+        }
+    }
+    return QAbstractTableModel::headerData(aSection, aOrientation, aRole);
+}
+
+/**
+ * @brief Gets the number of rows.
+ * @param aParent The parent of the rows. Only the root has rows.
+ * @return The number of songs that are shown.
+ */
+int SongListModel::rowCount(const QModelIndex& aParent) const
+{
+    return aParent.isValid() ? 0 : mDisplayOrder.count();
+}
+
+/**
+ * @brief Changes the order that the songs are shown in.
+ * @param aDisplayOrder The index in the song list of the Song to show in each row. It must have every song exactly once.
+ *
+ * The view is told that the layout changed, so it only repaints the rows that are on screen.
+ */
+void SongListModel::setDisplayOrder(const QVector<int>& aDisplayOrder)
+{
+    if(aDisplayOrder.count() != mDisplayOrder.count())
+    {
+        Q_ASSERT_X(false, "SongListModel::setDisplayOrder", "The display order doesn't have every song!");
+        return;
+    }
+
+    emit layoutAboutToBeChanged();
+
+    // Find the new row of each song, so that the selection and the current cell can follow their songs.
+    QVector<int> newRows(aDisplayOrder.count());
+    for(int row = 0; row < aDisplayOrder.count(); row++)
+    {
+        newRows[aDisplayOrder[row]] = row;
+    }
+    QModelIndexList oldIndices = persistentIndexList();
+    QModelIndexList newIndices;
+    newIndices.reserve(oldIndices.count());
+    for(const QModelIndex& oldIndex : oldIndices)
+    {
+        newIndices.append(index(newRows[mDisplayOrder[oldIndex.row()]], oldIndex.column()));
+    }
+
+    mDisplayOrder = aDisplayOrder;
+    changePersistentIndexList(oldIndices, newIndices);
+    emit layoutChanged();
+}
+
+/**
+ * @brief Sets the songs that are shown. They're shown in list order until the display order is changed.
+ * @param aSongList The list of songs. It isn't copied, so it must outlive the model or be replaced first. Null to show nothing.
+ */
+void SongListModel::setSongList(const QList<Song*>* aSongList)
+{
+    beginResetModel();
+    mSongList = aSongList;
+    mDisplayOrder.resize((mSongList != nullptr) ? mSongList->count() : 0);
+    for(int i = 0; i < mDisplayOrder.count(); i++)
+    {
+        mDisplayOrder[i] = i;
+    }
+    endResetModel();
+}
@@ -0,0 +1,34 @@
+#ifndef SONGLISTMODEL_H
+#define SONGLISTMODEL_H
+
+#include <QAbstractTableModel>
+#include <QList>
+#include <QModelIndex>
+#include <QModelIndexList>
+#include <QVariant>
+#include <QVector>
+#include "songHandling/song.h"
+
+#define SONG_LIST_MODEL_NUM_COLUMNS 5
+
+class SongListModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+    public:
+        explicit SongListModel(QObject *parent = 0);
+        ~SongListModel();
+
+        int columnCount(const QModelIndex& aParent = QModelIndex()) const override;
+        QVariant data(const QModelIndex& aIndex, int aRole = Qt::DisplayRole) const override;
+        QVariant headerData(int aSection, Qt::Orientation aOrientation, int aRole = Qt::DisplayRole) const override;
+        int rowCount(const QModelIndex& aParent = QModelIndex()) const override;
+        void setDisplayOrder(const QVector<int>& aDisplayOrder);
+        void setSongList(const QList<Song*>* aSongList);
+
+    private:
+        QVector<int> mDisplayOrder; //!< The index in the song list of the Song shown in each row.
+        const QList<Song*>* mSongList = nullptr; //!< The list of \link Song songs\endlink that are shown. Null if nothing is shown.
+};
+
+#endif // SONGLISTMODEL_H
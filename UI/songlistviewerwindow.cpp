@@ -9,6 +9,11 @@
   This class implements event handling for a window that displays lists of @link Song songs@endlink.
   The window has different @link SongListViewerWindow::SONG_LIST_MODE modes@endlink that it can
   be run in, and these modes dictate the actions that are available for the user in the window.
+
+  Songs that can be edited are shown in a table widget, with a widget for each checkbox and track number. The
+  results of a sort can't be edited, so they're shown in a table view over a @link SongListModel SongListModel@endlink
+  instead. It doesn't create anything per row, so large results open quickly, and sorting them by a column only
+  moves their rows.
 */
 
 //-----------------------------------------------
@@ -30,6 +35,10 @@ SongListViewerWindow::SongListViewerWindow(QWidget *parent) :
     ui(new Ui::SongListViewerWindow)
 {
     ui->setupUi(this);
+    ui->resultsTableView->setModel(&mSongListModel);
+    ui->resultsTableView->verticalHeader()->setVisible(false);
+    ui->resultsTableView->horizontalHeader()->setSortIndicatorShown(true);
+    connect(ui->resultsTableView->horizontalHeader(), SIGNAL(sectionClicked(int)), this, SLOT(on_tableHeaderClicked(int)));
 }
 
 /**
@@ -57,8 +66,32 @@ void SongListViewerWindow::setupSongListViewerWindow(SONG_LIST_MODE aSongListMod
     mChangesAccepted = false;
     mSongList = aSongList;
     mNumSongsAfterSave = mSongList->count();
+
+    // Songs are shown in list order until the results are sorted by a column.
+    mDisplayOrder.resize(mSongList->count());
+    for(int i = 0; i < mDisplayOrder.count(); i++)
+    {
+        mDisplayOrder[i] = i;
+    }
+    mSortKeys.clear();
+
+    // Results are shown in the results view, and everything else in the table so that it can be edited.
+    ui->resultsTableView->setVisible(mSongListMode == SHOW_RESULTS);
+    ui->songListTableWidget->setVisible(mSongListMode != SHOW_RESULTS);
     updateNumberOfSongsLabel();
-    fillTableWidget();
+    if(mSongListMode == SHOW_RESULTS)
+    {
+        ui->songListTableWidget->setRowCount(0);
+        mSongListSorter.setSongs(*mSongList);
+        mSongListModel.setSongList(mSongList);
+        setColumnWidths(ui->resultsTableView->horizontalHeader());
+        ui->resultsTableView->horizontalHeader()->setSortIndicator(CHECKBOX_OR_RANK_COLUMN, Qt::AscendingOrder);
+    }
+    else
+    {
+        mSongListModel.setSongList(nullptr);
+        fillTableWidget();
+    }
 }
 
 //-----------------------------------------------
@@ -90,6 +123,12 @@ void SongListViewerWindow::closeEvent(QCloseEvent *event)
         {
             emit songListEdited();
         }
+        else if(mSongListMode == SONG_LIST_MODE::SHOW_RESULTS)
+        {
+            // The results view reads the songs as it paints, so stop showing them before the list can change.
+            mSongListModel.setSongList(nullptr);
+            emit resultsWindowClosed();
+        }
         event->accept();
     }
 
@@ -118,7 +157,7 @@ void SongListViewerWindow::on_buttonBox_accepted()
             emit songListEdited();
             break;
         case SHOW_RESULTS:
-            emit resultsWindowClosed();
+            // The results can also be closed from the title bar, so closeEvent emits resultsWindowClosed for both.
             break;
         default:
             Q_ASSERT_X(false, "SongListViewerWindow::on_buttonBox_accepted", "Reached default case when it shouldn't have!");
@@ -128,6 +167,7 @@ void SongListViewerWindow::on_buttonBox_accepted()
     // Clear dialog contents. The song list is shared, so we don't need to delete it.
     mSongList = nullptr;
     ui->songListTableWidget->clear();
+    mSongListModel.setSongList(nullptr);
     mSongEdits.clear();
     mUnsavedChanges = false;
     close();
@@ -156,10 +196,12 @@ void SongListViewerWindow::on_songListTableWidget_cellChanged(int row, int colum
     mEditsOccurred = true;
     mUnsavedChanges = true;
 
-    // See if this song has already been edited. If not, then add it to the map.
-    if(!mSongEdits.contains(row))
+    // See if this song has already been edited. If not, then add it to the map. Edits are kept by song id
+    // rather than by row, so they stay with their song wherever it's shown.
+    quint64 songId = (*mSongList)[mDisplayOrder[row]]->getId();
+    if(!mSongEdits.contains(songId))
     {
-        mSongEdits.insert(row, song_edit());
+        mSongEdits.insert(songId, song_edit());
     }
     // Mark that we should update the song if the dialog is confirmed.
     switch(column)
@@ -169,22 +211,22 @@ void SongListViewerWindow::on_songListTableWidget_cellChanged(int row, int colum
             // Note: Results can't be edited, so this case only matters for when the column has checkboxes.
             // A checked checkbox means keep the song. If it's unchecked, then it means that the song should be removed from the list.
             QCheckBox* checkBox = (QCheckBox*)ui->songListTableWidget->cellWidget(row, CHECKBOX_OR_RANK_COLUMN)->layout()->itemAt(0)->widget();
-            mSongEdits[row].remove_song = (!checkBox->isChecked());
-            mSongEdits[row].remove_song ? mNumSongsAfterSave-- : mNumSongsAfterSave++;
+            mSongEdits[songId].remove_song = (!checkBox->isChecked());
+            mSongEdits[songId].remove_song ? mNumSongsAfterSave-- : mNumSongsAfterSave++;
             updateNumberOfSongsLabel();
             break;
         }
         case ARTIST_COLUMN:
-            mSongEdits[row].artist_edited = true;
+            mSongEdits[songId].artist_edited = true;
             break;
         case ALBUM_COLUMN:
-            mSongEdits[row].album_edited = true;
+            mSongEdits[songId].album_edited = true;
             break;
         case TRACK_NUMBER_COLUMN:
-            mSongEdits[row].track_number_edited = true;
+            mSongEdits[songId].track_number_edited = true;
             break;
         case SONG_NAME_COLUMN:
-            mSongEdits[row].song_name_edited = true;
+            mSongEdits[songId].song_name_edited = true;
             break;
         default:
             Q_ASSERT_X(false, "SongListViewerWindow::on_songListTableWidget_cellChanged", "Reached default case when we shouldn't have!");
@@ -193,6 +235,86 @@ void SongListViewerWindow::on_songListTableWidget_cellChanged(int row, int colum
 
 }
 
+/*!
+ * @brief Handles a column header of the table being clicked.
+ * @param aColumn The column whose header was clicked.
+ *
+ * When the results are shown, clicking a header sorts them by that column. Clicking the same header again
+ * reverses the order. The previous sort keys are kept to break ties, so clicking Track, then Album, then Artist
+ * sorts by artist, then album, then track. Sorting by artist or album also sorts each album by track.
+ */
+void SongListViewerWindow::on_tableHeaderClicked(int aColumn)
+{
+    if(mSongListMode != SHOW_RESULTS)
+    {
+        return;
+    }
+
+    // Declare variables.
+    SongListSorter::sort_key clickedKey;
+    QVector<SongListSorter::sort_key> newSortKeys;
+
+    switch(aColumn)
+    {
+        case CHECKBOX_OR_RANK_COLUMN:
+            clickedKey.field = SongListSorter::RANK;
+            break;
+        case ARTIST_COLUMN:
+            clickedKey.field = SongListSorter::ARTIST;
+            break;
+        case ALBUM_COLUMN:
+            clickedKey.field = SongListSorter::ALBUM;
+            break;
+        case TRACK_NUMBER_COLUMN:
+            clickedKey.field = SongListSorter::TRACK_NUMBER;
+            break;
+        case SONG_NAME_COLUMN:
+            clickedKey.field = SongListSorter::SONG_NAME;
+            break;
+        default:
+            Q_ASSERT_X(false, "SongListViewerWindow::on_tableHeaderClicked", "Reached default case when we shouldn't have!");
+            return;
+    }
+    clickedKey.ascending = mSortKeys.isEmpty() || mSortKeys.first().field != clickedKey.field || !mSortKeys.first().ascending;
+    if(mSortKeys.isEmpty() && clickedKey.field == SongListSorter::RANK)
+    {
+        // The results start out sorted by rank, so the first click on Rank reverses them.
+        clickedKey.ascending = false;
+    }
+
+    // Put the clicked column first, followed by the columns that naturally go with it and then the previous keys.
+    newSortKeys.append(clickedKey);
+    if(clickedKey.field == SongListSorter::ARTIST || clickedKey.field == SongListSorter::ALBUM)
+    {
+        SongListSorter::sort_key followingKey;
+        if(clickedKey.field == SongListSorter::ARTIST)
+        {
+            followingKey.field = SongListSorter::ALBUM;
+            newSortKeys.append(followingKey);
+        }
+        followingKey.field = SongListSorter::TRACK_NUMBER;
+        newSortKeys.append(followingKey);
+    }
+    for(const SongListSorter::sort_key& previousKey : mSortKeys)
+    {
+        bool alreadyUsed = false;
+        for(const SongListSorter::sort_key& newKey : newSortKeys)
+        {
+            alreadyUsed = alreadyUsed || (newKey.field == previousKey.field);
+        }
+        if(!alreadyUsed)
+        {
+            newSortKeys.append(previousKey);
+        }
+    }
+    mSortKeys = newSortKeys;
+
+    // Sort the results and move their rows into the new order. Nothing is created, so this is fast for any number of songs.
+    mDisplayOrder = mSongListSorter.getSortedOrder(mSortKeys);
+    mSongListModel.setDisplayOrder(mDisplayOrder);
+    ui->resultsTableView->horizontalHeader()->setSortIndicator(aColumn, clickedKey.ascending ? Qt::AscendingOrder : Qt::DescendingOrder);
+}
+
 //-----------------------------------------------
 // Private Functions
 //-----------------------------------------------
@@ -228,12 +350,10 @@ bool SongListViewerWindow::confirmCancel()
  * @brief Fills the table in the window with the contents of the Song list.
  *
  * The table is formatted as follows:
- * @n If the window is in @link SongListViewerWindow::SONG_LIST_MODE SHOW_RESULTS mode@endlink:
- * @n Rank   Artist   Album   Track Number  Song Name
- * @n @n Otherwise, the table is:
  * @n Keep?   Artist   Album   Track Number  Song Name
  * @n where the Keep column contains a checkbox.
  *
+ * This is only used for the modes where the songs can be edited. The results are shown in the results view.
  */
 void SongListViewerWindow::fillTableWidget()
 {
@@ -242,92 +362,75 @@ void SongListViewerWindow::fillTableWidget()
 
     // Declare variables
     int numSongs = mSongList->count();
-    QStringList headerLabels;
     QTableWidgetItem* artistItem = nullptr;
     QTableWidgetItem* albumItem = nullptr;
     QSpinBox* trackNumberItem = nullptr;
     QTableWidgetItem* songNameItem = nullptr;
 
-    // Set the attributes of the table.
+    // Set the attributes of the table. The old rows are removed first so that no cell widgets are left over.
+    ui->songListTableWidget->setRowCount(0);
     ui->songListTableWidget->setRowCount(numSongs);
     ui->songListTableWidget->setColumnCount(5);
-    ui->songListTableWidget->setColumnWidth(CHECKBOX_OR_RANK_COLUMN, 60);
-    ui->songListTableWidget->setColumnWidth(ARTIST_COLUMN, 390);
-    ui->songListTableWidget->setColumnWidth(ALBUM_COLUMN, 390);
-    ui->songListTableWidget->setColumnWidth(TRACK_NUMBER_COLUMN, 60);
-    ui->songListTableWidget->setColumnWidth(SONG_NAME_COLUMN, 390);
+    setColumnWidths(ui->songListTableWidget->horizontalHeader());
     ui->songListTableWidget->verticalHeader()->setVisible(false);
-
-    // If we're confirming imported songs or allowing the user to edit the song list,
-    // then we want a checkbox to allow for the user to decide whether or not to include the song
-    // in the sorting. If we're showing the results, then we want to put the song ranking instead
-    // of the checkbox.
-    if(mSongListMode == SHOW_RESULTS)
-    {
-        headerLabels << "Rank";
-    }
-    else
-    {
-        headerLabels << "Keep?";
-    }
-    headerLabels << "Artist" << "Album" << "Track" << "Song Name";
-    ui->songListTableWidget->setHorizontalHeaderLabels(headerLabels);
+    ui->songListTableWidget->setHorizontalHeaderLabels(QStringList() << "Keep?" << "Artist" << "Album" << "Track" << "Song Name");
 
     // Add all of the songs to the table.
     for(int i = 0; i < numSongs; i++)
     {
-        // If we're showing the results of the sort, then we want to put the rank of the song
-        // in the first column. Otherwise, we want to put a checkbox.
-        if(mSongListMode == SHOW_RESULTS)
-        {
-            QTableWidgetItem* rankEntry = new QTableWidgetItem();
-            rankEntry->setText(QString("%1").arg((*mSongList)[i]->getRank()));
-            rankEntry->setFlags(rankEntry->flags() ^ Qt::ItemIsEditable);
-            ui->songListTableWidget->setItem(i, CHECKBOX_OR_RANK_COLUMN, rankEntry);
-
-
-        }
-        else
-        {
-            // Create a widget to contain the check box. We need this so the check box can
-            // be centered in the cell.
-            QWidget* checkBoxWidget = new QWidget(ui->songListTableWidget);
-            QHBoxLayout* checkBoxWidgetLayout = new QHBoxLayout(checkBoxWidget);
-            QCheckBox* checkBox = new QCheckBox(checkBoxWidget);
-            checkBox->setChecked(true);
-            checkBoxWidgetLayout->setAlignment(Qt::AlignHCenter);
-            checkBoxWidgetLayout->setContentsMargins(0, 0, 0, 0);
-            checkBoxWidgetLayout->addWidget(checkBox);
-            checkBoxWidget->setLayout(checkBoxWidgetLayout);
-            ui->songListTableWidget->setCellWidget(i, CHECKBOX_OR_RANK_COLUMN, checkBoxWidget);
-            connect(checkBox, &QCheckBox::toggled, [=](){ this->on_songListTableWidget_cellChanged(i, CHECKBOX_OR_RANK_COLUMN);});
-        }
+        Song* song = (*mSongList)[mDisplayOrder[i]];
+
+        // Create a widget to contain the check box. We need this so the check box can
+        // be centered in the cell. The check box lets the user decide whether or not to keep the song.
+        QWidget* checkBoxWidget = new QWidget(ui->songListTableWidget);
+        QHBoxLayout* checkBoxWidgetLayout = new QHBoxLayout(checkBoxWidget);
+        QCheckBox* checkBox = new QCheckBox(checkBoxWidget);
+        checkBox->setChecked(true);
+        checkBoxWidgetLayout->setAlignment(Qt::AlignHCenter);
+        checkBoxWidgetLayout->setContentsMargins(0, 0, 0, 0);
+        checkBoxWidgetLayout->addWidget(checkBox);
+        checkBoxWidget->setLayout(checkBoxWidgetLayout);
+        ui->songListTableWidget->setCellWidget(i, CHECKBOX_OR_RANK_COLUMN, checkBoxWidget);
+        connect(checkBox, &QCheckBox::toggled, [=](){ this->on_songListTableWidget_cellChanged(i, CHECKBOX_OR_RANK_COLUMN);});
 
         // Create the entries for the artist name, album name, and song name.
-        artistItem = new QTableWidgetItem((*mSongList)[i]->getArtistName());
+        artistItem = new QTableWidgetItem(song->getArtistName());
         artistItem->setTextAlignment(Qt::AlignHCenter|Qt::AlignVCenter);
-        albumItem = new QTableWidgetItem((*mSongList)[i]->getAlbumName());
+        albumItem = new QTableWidgetItem(song->getAlbumName());
         albumItem->setTextAlignment(Qt::AlignHCenter|Qt::AlignVCenter);
-        songNameItem = new QTableWidgetItem((*mSongList)[i]->getSongName());
+        songNameItem = new QTableWidgetItem(song->getSongName());
         songNameItem->setTextAlignment(Qt::AlignHCenter|Qt::AlignVCenter);
 
+        // Insert the items.
+        ui->songListTableWidget->setItem(i, ARTIST_COLUMN, artistItem);
+        ui->songListTableWidget->setItem(i, ALBUM_COLUMN, albumItem);
+        ui->songListTableWidget->setItem(i, SONG_NAME_COLUMN, songNameItem);
+
         // Set up the track number entry. These entries require connecting to their valueChanged signal.
         trackNumberItem = new QSpinBox(ui->songListTableWidget);
         trackNumberItem->setAlignment(Qt::AlignHCenter);
-        trackNumberItem->setValue((*mSongList)[i]->getTrackNumber());
+        trackNumberItem->setValue(song->getTrackNumber());
         connect(trackNumberItem, qOverload<int>(&QSpinBox::valueChanged), [=](int){ this->on_songListTableWidget_cellChanged(i,TRACK_NUMBER_COLUMN); });
-
-        // Insert the items.
-        ui->songListTableWidget->setItem(i, ARTIST_COLUMN, artistItem);
-        ui->songListTableWidget->setItem(i, ALBUM_COLUMN, albumItem);
         ui->songListTableWidget->setCellWidget(i, TRACK_NUMBER_COLUMN, trackNumberItem);
-        ui->songListTableWidget->setItem(i, SONG_NAME_COLUMN, songNameItem);
     }
 
     // We can unblock signals now that the table is filled.
     signalBlocker.unblock();
 }
 
+/**
+ * @brief Sets the widths of the columns of the table or the results view.
+ * @param aHeader The column header of the table or view.
+ */
+void SongListViewerWindow::setColumnWidths(QHeaderView* aHeader)
+{
+    aHeader->resizeSection(CHECKBOX_OR_RANK_COLUMN, 60);
+    aHeader->resizeSection(ARTIST_COLUMN, 390);
+    aHeader->resizeSection(ALBUM_COLUMN, 390);
+    aHeader->resizeSection(TRACK_NUMBER_COLUMN, 60);
+    aHeader->resizeSection(SONG_NAME_COLUMN, 390);
+}
+
 /**
  * @brief Updates the label at the bottom of the SongListViewerWindow.
  */
@@ -367,52 +470,60 @@ void SongListViewerWindow::updateSongListFromTable()
     // See if we need to update any metadata.
     if(mEditsOccurred)
     {
-        // The keys in the map correspond to a song's placement in the song list.
-        // Get them in descending order so that we can modify the song list
-        // without worrying about indices changing.
-        QList<int> songListIndices = mSongEdits.keys();
-        std::sort(songListIndices.begin(), songListIndices.end(), std::greater<int>());
-        QMutableListIterator<int> iter(songListIndices);
-
         // Declare variables.
-        int index = 0;
+        QSet<quint64> removedSongIds;
         QSpinBox* trackNumberSpinBox = nullptr;
 
-
-        // Handle all of the song edits.
-        while(iter.hasNext())
+        // The edits are keyed by song id, so go through the rows of the table to find each edited song and its cells.
+        for(int row = 0; row < ui->songListTableWidget->rowCount(); row++)
         {
-            index = iter.next();
+            Song* song = (*mSongList)[mDisplayOrder[row]];
+            QHash<quint64, song_edit>::const_iterator edit = mSongEdits.constFind(song->getId());
+            if(edit == mSongEdits.constEnd())
+            {
+                continue;
+            }
 
             // See if we need to remove the song. Other edits for the song don't matter if we're
             // removing it anyway.
-            if(mSongEdits[index].remove_song)
+            if(edit->remove_song)
             {
-                Song* songToRemove = mSongList->takeAt(index);
-                Q_ASSERT_X(songToRemove != nullptr, "SongListViewerWindow::updateSongListFromTable", "Somehow we're trying to delete a null song!");
-                delete songToRemove;
+                removedSongIds.insert(song->getId());
+                continue;
             }
-            else
+
+            // Update the metadata of the song as needed.
+            if(edit->artist_edited)
             {
-                // Update the metadata of the song as needed.
-                if(mSongEdits[index].artist_edited)
-                {
-                    (*mSongList)[index]->setArtistName(ui->songListTableWidget->item(index, ARTIST_COLUMN)->text());
-                }
-                if(mSongEdits[index].album_edited)
-                {
-                    (*mSongList)[index]->setAlbumName(ui->songListTableWidget->item(index, ALBUM_COLUMN)->text());
-                }
-                if(mSongEdits[index].track_number_edited)
-                {
-                    trackNumberSpinBox = (QSpinBox*)ui->songListTableWidget->cellWidget(index, TRACK_NUMBER_COLUMN);
-                    (*mSongList)[index]->setTrackNumber(trackNumberSpinBox->value());
-                }
-                if(mSongEdits[index].song_name_edited)
+                song->setArtistName(ui->songListTableWidget->item(row, ARTIST_COLUMN)->text());
+            }
+            if(edit->album_edited)
+            {
+                song->setAlbumName(ui->songListTableWidget->item(row, ALBUM_COLUMN)->text());
+            }
+            if(edit->track_number_edited)
+            {
+                trackNumberSpinBox = (QSpinBox*)ui->songListTableWidget->cellWidget(row, TRACK_NUMBER_COLUMN);
+                song->setTrackNumber(trackNumberSpinBox->value());
+            }
+            if(edit->song_name_edited)
+            {
+                song->setSongName(ui->songListTableWidget->item(row, SONG_NAME_COLUMN)->text());
+            }
+        }
+
+        // Remove the songs in a single pass. They're released by the batch that owns them once the list is saved.
+        if(!removedSongIds.isEmpty())
+        {
+            QList<Song*> keptSongs;
+            for(Song* song : *mSongList)
+            {
+                if(!removedSongIds.contains(song->getId()))
                 {
-                    (*mSongList)[index]->setSongName(ui->songListTableWidget->item(index, SONG_NAME_COLUMN)->text());
+                    keptSongs.append(song);
                 }
             }
+            *mSongList = keptSongs;
         }
     }
 }
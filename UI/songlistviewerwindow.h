@@ -8,13 +8,17 @@
 #include <QDebug>
 #include <QDialog>
 #include <QDir>
+#include <QHash>
 #include <QHBoxLayout>
-#include <QMap>
+#include <QHeaderView>
 #include <QMessageBox>
 #include <QPushButton>
+#include <QSet>
 #include <QSpinBox>
 #include <QString>
 #include "songHandling/song.h"
+#include "songHandling/songlistsorter.h"
+#include "UI/songlistmodel.h"
 
 #define CHECKBOX_OR_RANK_COLUMN 0
 #define ARTIST_COLUMN 1
@@ -57,6 +61,7 @@ class SongListViewerWindow : public QMainWindow
         void on_buttonBox_accepted();
         void on_buttonBox_rejected();
         void on_songListTableWidget_cellChanged(int row, int column);
+        void on_tableHeaderClicked(int aColumn);
 
     private:
         /**
@@ -73,6 +78,7 @@ class SongListViewerWindow : public QMainWindow
 
         bool confirmCancel();
         void fillTableWidget();
+        void setColumnWidths(QHeaderView* aHeader);
         void updateNumberOfSongsLabel();
         void updateSongListFromTable();
 
@@ -82,9 +88,13 @@ class SongListViewerWindow : public QMainWindow
         bool mEditsOccurred = false; //!< Whether or not edits have occurred.
         bool mUnsavedChanges = false; //!< Whether or not there are unsaved changes.
         int mNumSongsAfterSave = 0; //!< The number of songs that will be in the saved song list should the user save.
+        QVector<int> mDisplayOrder; //!< The index in the song list of the Song shown in each row of the table or of the results view.
         QList<Song*>* mSongList = nullptr; //!< The list of \link Song songs\endlink that are displayed in the viewer.
-        QMap<int, song_edit> mSongEdits; //!< A map that connects the edits that have occurred to the index of the Song in the song list.
+        SongListModel mSongListModel; //!< Shows the results in the results view, in the display order.
+        SongListSorter mSongListSorter; //!< Sorts the results when a column header is clicked.
+        QHash<quint64, song_edit> mSongEdits; //!< The edits that have occurred, keyed by the \link Song::getId id\endlink of the Song that they were made to.
         SONG_LIST_MODE mSongListMode = CONFIRM_IMPORTED_SONGS; //!< The \link SONG_LIST_MODE mode\endlink that the song list viewer is in.
+        QVector<SongListSorter::sort_key> mSortKeys; //!< The keys that the results are sorted by, most significant first.
 
         static const QString msEditMainSongListLabel; //!< The label at the bottom of the window when it is being used to edit the main song list.
         static const QString msConfirmImportedSongsLabel; //!< The label at the bottom of the window when it is being used to confirm imported songs.
@@ -16,7 +16,6 @@
 //-----------------------------------------------
 
 const QString StartupWindow::mNumSongsLabel = QString("Number of songs that will be sorted: ");
-QStringList StartupWindow::msSupportedFileExtensions = QStringList() << "*.mp3" << "*.flac";
 
 
 //-----------------------------------------------
@@ -28,25 +27,42 @@ QStringList StartupWindow::msSupportedFileExtensions = QStringList() << "*.mp3"
  * @param parent The parent of the window.
  *
  * The constructor sets up the UI for the StartupWindow and connects signals to its
- * slots.
+ * slots. The settings from the last session are shown in the UI.
 */
 StartupWindow::StartupWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::StartupWindow)
+    ui(new Ui::StartupWindow),
+    mPreferenceStore(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/preferences.dat"),
+    mSettings(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/settings.ini", QSettings::IniFormat)
 {
     // Set up the UI and other windows.
     ui->setupUi(this);
+    mAudioAnalyzer = new AudioAnalyzer(this);
     mComparisonWindow = new ComparisonWindow(this);
+    mComparisonWindow->setAudioAnalyzer(mAudioAnalyzer);
+    mComparisonWindow->setPreferenceStore(&mPreferenceStore);
     mSongListViewerWindow = new SongListViewerWindow(this);
+    mTagWorkerPool = new TagWorkerPool(this);
+    mTagWriter = new TagWriter(this);
     mComparisonWindow->hide();
     mSongListViewerWindow->hide();
     ui->viewSongListButton->setEnabled(false);
     ui->beginSortingButton->setEnabled(false);
+    ui->writeRanksButton->setEnabled(false);
+    ui->excludePatternsLineEdit->setText(mSettings.value(EXCLUDE_PATTERNS_SETTING).toStringList().join(QString("%1 ").arg(EXCLUDE_PATTERN_SEPARATOR)));
 
     // Connect slots.
     connect(mSongListViewerWindow, SIGNAL(importedSongsConfirmed()), this, SLOT(on_importedSongsConfirmed()));
     connect(mSongListViewerWindow, SIGNAL(songListEdited()), this, SLOT(on_songListEdited()));
     connect(mSongListViewerWindow, SIGNAL(importCancelled()), this, SLOT(on_SongListViewerWindowCancelled()));
+    connect(mSongListViewerWindow, SIGNAL(resultsWindowClosed()), this, SLOT(on_resultsWindowClosed()));
+    connect(mComparisonWindow, SIGNAL(sortingCancelled()), this, SLOT(on_sortingCancelled()));
+    connect(mComparisonWindow, SIGNAL(sortingFinished()), this, SLOT(on_sortingFinished()));
+    connect(mTagWriter, SIGNAL(progressChanged(int,int)), this, SLOT(on_tagWriteProgressChanged(int,int)));
+    connect(mTagWriter, SIGNAL(writingFinished(int)), this, SLOT(on_tagWritingFinished(int)));
+
+    // Finish writing any ranks that were interrupted when the app was last closed.
+    mTagWriter->resumePendingWrites();
 }
 
 /**
@@ -56,27 +72,9 @@ StartupWindow::~StartupWindow()
 {
     delete ui;
 
-    // Delete the songs in the main list.
-    Song* songToDelete = nullptr;
-    QMutableListIterator<Song*> iter(mSongs);
-    while(iter.hasNext())
-    {
-        songToDelete = iter.next();
-        iter.remove();
-        delete songToDelete;
-        songToDelete = nullptr;
-    }
-
-    // Delete the songs in the imported song list.
-    iter = QMutableListIterator<Song*>(mSongsFromSelectedFolder);
-    while(iter.hasNext())
-    {
-        songToDelete = iter.next();
-        iter.remove();
-        delete songToDelete;
-        songToDelete = nullptr;
-    }
-
+    // The songs are destroyed with the batches that own them.
+    mSongs.clear();
+    mSongsFromSelectedFolder.clear();
 }
 
 //-----------------------------------------------
@@ -99,53 +97,28 @@ void StartupWindow::on_addFolderButton_released()
 
     if(openedDirectory != "")
     {
-        // If the chosen directory contains songs to import, then get their metadata and create a container for them.
-        QDirIterator iter(openedDirectory, msSupportedFileExtensions, QDir::Filter::NoFilter, QDirIterator::FollowSymlinks|QDirIterator::Subdirectories);
-        if(iter.hasNext())
-        {
-            // Declare variables.
-            TagLib::FileRef file;
-            int currentPathLength = 0;
-            int trackNumber = 1;
-            QString currentPath, artist, album, songName;
-            Song* newSong = nullptr;
-            wchar_t* filePathForTaglib = nullptr;
-
-            // Get the metadata of all of the songs in the chosen directory.
-            while(iter.hasNext())
-            {
-                // Convert the QString containing the current path so that we can use it with taglib.
-                currentPath = iter.next();
-                currentPathLength = currentPath.length();
-                filePathForTaglib = new wchar_t[currentPathLength + 1];
-                currentPath.toWCharArray(filePathForTaglib);
-                filePathForTaglib[currentPathLength] = L'\0';
-
-                // Use Taglib to get the metadata of the song.
-                file = TagLib::FileRef(TagLib::FileName(filePathForTaglib));
-                if(!file.isNull() && file.tag() != nullptr)
-                {
-                    artist = QString(file.tag()->artist().toCString(true));
-                    album = QString(file.tag()->album().toCString(true));
-                    songName = QString(file.tag()->title().toCString(true));
-                    trackNumber = (int)file.tag()->track();
-                    newSong = new Song(trackNumber, album, artist, currentPath, songName);
-
-                    // Add the new song to the list of imported songs.
-                    mSongsFromSelectedFolder.append(newSong);
-                }
-
-                // Clear allocated memory.
-                delete [] filePathForTaglib;
-                filePathForTaglib = nullptr;
-            }
-        }
+        // Find the songs in the chosen directory, and then get their metadata and create a container for them.
+        DirectoryTraverser traverser;
+        traverser.setExcludePatterns(getExcludePatterns());
+        QVector<IoScheduler::file_location> locations;
+        QStringList songFiles = traverser.findSongFiles(openedDirectory, &locations);
+        importSongFiles(songFiles, locations);
     }
+}
 
-    // If we found songs in the selected folder, then let the user confirm which ones they want to import.
-    if(mSongsFromSelectedFolder.count() > 0)
+/**
+ * @brief Handles when the Add Playlist button is pressed and released.
+ *
+ * When the Add Playlist button is pressed and released, a dialog will show to allow the user to pick a
+ * playlist or library manifest file. Only the songs listed in the file are imported.
+ */
+void StartupWindow::on_addPlaylistButton_released()
+{
+    QString playlistFilter = QString("Playlists (*.%1)").arg(PlaylistParser::msSupportedPlaylistExtensions.join(" *."));
+    QString openedPlaylist = QFileDialog::getOpenFileName(this, "Add a playlist", QString(), playlistFilter);
+    if(openedPlaylist != "")
     {
-        showSongListViewerWindow(SongListViewerWindow::SONG_LIST_MODE::CONFIRM_IMPORTED_SONGS);
+        importSongFiles(PlaylistParser::parsePlaylist(openedPlaylist));
     }
 }
 
@@ -153,12 +126,27 @@ void StartupWindow::on_addFolderButton_released()
  * @brief Handles the Begin Sorting! button being clicked and released.
  *
  * This function will close the StartupWindow and open the ComparisonWindow
- * to begin sorting the songs.
+ * to begin sorting the songs. The number of songs shown per comparison is taken
+ * from the songs per comparison spin box, and what songs are sorted within first is
+ * taken from the sort grouping combo box. Songs that were imported after a finished
+ * sort are inserted into its ranking rather than sorting everything again.
  */
 void StartupWindow::on_beginSortingButton_released()
 {
     mComparisonWindow->show();
     hide();
+    mComparisonWindow->setupComparisonWindow(&mSongs, ui->songsPerComparisonSpinBox->value(),
+                                             (ComparisonWindow::SORT_GROUPING)ui->sortGroupingComboBox->currentIndex());
+}
+
+/**
+ * @brief Handles the user finishing an edit of the exclude patterns.
+ *
+ * The patterns are saved so that they're used again in the next session.
+ */
+void StartupWindow::on_excludePatternsLineEdit_editingFinished()
+{
+    mSettings.setValue(EXCLUDE_PATTERNS_SETTING, getExcludePatterns());
 }
 
 /**
@@ -170,10 +158,16 @@ void StartupWindow::on_beginSortingButton_released()
  */
 void StartupWindow::on_importedSongsConfirmed()
 {
-    // Re-enable the "Add a Folder" button.
+    // Re-enable the "Add a Folder" and "Add a playlist" buttons.
     ui->addFolderButton->setEnabled(true);
+    ui->addPlaylistButton->setEnabled(true);
+
+    // Release the songs that weren't confirmed, then move the rest of the import into the library without copying them.
+    mImportBatch.retainSongs(mSongsFromSelectedFolder);
+    mLibraryBatch.merge(&mImportBatch);
 
-    // Append the imported songs to the main list.
+    // Append the imported songs to the main list and start analyzing them in the background.
+    mAudioAnalyzer->analyzeSongs(mSongsFromSelectedFolder);
     mSongs.append(mSongsFromSelectedFolder);
     mSongsFromSelectedFolder.clear();
 
@@ -182,6 +176,17 @@ void StartupWindow::on_importedSongsConfirmed()
     updateUi();
 }
 
+/*!
+ * @brief Slot that handles the SongListViewerWindow being closed while it was showing the results of the sort.
+ */
+void StartupWindow::on_resultsWindowClosed()
+{
+    show();
+    ui->addFolderButton->setEnabled(true);
+    ui->addPlaylistButton->setEnabled(true);
+    updateUi();
+}
+
 /*!
  * @brief A slot that handles when the song list is edited in the SongListViewerWindow.
  *
@@ -190,24 +195,77 @@ void StartupWindow::on_importedSongsConfirmed()
  */
 void StartupWindow::on_songListEdited()
 {
+    // Release the songs that were removed from the main list.
+    mLibraryBatch.retainSongs(mSongs);
+
     show();
     ui->addFolderButton->setEnabled(true);
+    ui->addPlaylistButton->setEnabled(true);
+    updateUi();
+}
+
+/*!
+ * @brief Slot that handles the ComparisonWindow being closed before the sort was finished.
+ */
+void StartupWindow::on_sortingCancelled()
+{
+    show();
     updateUi();
 }
 
+/*!
+ * @brief Slot that handles the ComparisonWindow finishing the sort.
+ *
+ * The main song list is in rank order at this point, so the results are shown in the SongListViewerWindow.
+ */
+void StartupWindow::on_sortingFinished()
+{
+    showSongListViewerWindow(SongListViewerWindow::SONG_LIST_MODE::SHOW_RESULTS);
+}
+
 /*!
  * @brief Slot that handles the SongListViewerWindow being cancelled or exited.
  *
- * This function just resets the import process and updates the ui.
+ * This function just resets the import process and updates the ui. All of the imported songs are freed at once
+ * with their batch.
  */
 void StartupWindow::on_SongListViewerWindowCancelled()
 {
     ui->addFolderButton->setEnabled(true);
+    ui->addPlaylistButton->setEnabled(true);
     mSongsFromSelectedFolder.clear();
+    mImportBatch.clear();
     show();
     updateUi();
 }
 
+/*!
+ * @brief Slot that shows the progress of writing ranks into the song files.
+ * @param aNumFinished The number of files that have been written or have failed.
+ * @param aNumFiles The number of files being written.
+ */
+void StartupWindow::on_tagWriteProgressChanged(int aNumFinished, int aNumFiles)
+{
+    ui->statusBar->showMessage(QString("Saving ranks to files: %1 of %2").arg(aNumFinished).arg(aNumFiles));
+}
+
+/*!
+ * @brief Slot that handles every rank having been written into the song files.
+ * @param aNumFailed The number of files that couldn't be written.
+ */
+void StartupWindow::on_tagWritingFinished(int aNumFailed)
+{
+    if(aNumFailed > 0)
+    {
+        ui->statusBar->showMessage(QString("Ranks saved. %1 files couldn't be written.").arg(aNumFailed));
+    }
+    else
+    {
+        ui->statusBar->showMessage("Ranks saved.");
+    }
+    updateUi();
+}
+
 /*!
  * @brief Handles the View Songs button being clicked and released.
  *
@@ -219,10 +277,86 @@ void StartupWindow::on_viewSongListButton_released()
     showSongListViewerWindow(SongListViewerWindow::SONG_LIST_MODE::EDIT_MAIN_SONG_LIST);
 }
 
+/*!
+ * @brief Handles the Save Ranks to Files button being clicked and released.
+ *
+ * The ranks of the sorted songs are written into the tags of their files in the background, so that other
+ * players can pick them up.
+ */
+void StartupWindow::on_writeRanksButton_released()
+{
+    if(mTagWriter->writeRanks(mSongs))
+    {
+        ui->writeRanksButton->setEnabled(false);
+    }
+}
+
 //-----------------------------------------------
 // Private Functions
 //-----------------------------------------------
 
+/**
+ * @brief Gets the exclude patterns that the user entered.
+ * @return The wildcard patterns, such as ".*" or "Podcasts". Files and folders whose names match any of them
+ * are skipped when a folder is added.
+ */
+QStringList StartupWindow::getExcludePatterns() const
+{
+    QStringList excludePatterns;
+    for(const QString& pattern : ui->excludePatternsLineEdit->text().split(EXCLUDE_PATTERN_SEPARATOR))
+    {
+        if(!pattern.trimmed().isEmpty())
+        {
+            excludePatterns.append(pattern.trimmed());
+        }
+    }
+    return excludePatterns;
+}
+
+/**
+ * @brief Reads the tags of song files and lets the user confirm which ones to import.
+ * @param aFilePaths The paths of the song files.
+ * @param aLocations Where each file is stored, if it's already known. Otherwise, the locations are looked up.
+ */
+void StartupWindow::importSongFiles(const QStringList& aFilePaths, const QVector<IoScheduler::file_location>& aLocations)
+{
+    // The window keeps responding while the tags are read, so don't let another import start in the meantime.
+    ui->addFolderButton->setEnabled(false);
+    ui->addPlaylistButton->setEnabled(false);
+
+    // Leave out the files that are already in the library or are listed more than once, so that importing a
+    // folder again only adds the songs that are new to it.
+    QStringList newFilePaths;
+    QVector<IoScheduler::file_location> newLocations;
+    QSet<quint64> newSongIds;
+    bool hasLocations = (aLocations.count() == aFilePaths.count());
+    for(int i = 0; i < aFilePaths.count(); i++)
+    {
+        quint64 songId = Song::getPathId(aFilePaths[i]);
+        if(mLibraryBatch.getSong(songId) == nullptr && !newSongIds.contains(songId))
+        {
+            newSongIds.insert(songId);
+            newFilePaths.append(aFilePaths[i]);
+            if(hasLocations)
+            {
+                newLocations.append(aLocations[i]);
+            }
+        }
+    }
+    mSongsFromSelectedFolder.append(mTagWorkerPool->readSongs(newFilePaths, &mImportBatch, newLocations));
+
+    // If we found songs, then let the user confirm which ones they want to import.
+    if(mSongsFromSelectedFolder.count() > 0)
+    {
+        showSongListViewerWindow(SongListViewerWindow::SONG_LIST_MODE::CONFIRM_IMPORTED_SONGS);
+    }
+    else
+    {
+        ui->addFolderButton->setEnabled(true);
+        ui->addPlaylistButton->setEnabled(true);
+    }
+}
+
 /**
  * @brief Shows the SongListViewerWindow.
  * @param aSongListMode The @link SongListViewerWindow::SONG_LIST_MODE mode@endlink in which to run the song list viewer.
@@ -231,6 +365,7 @@ void StartupWindow::showSongListViewerWindow(SongListViewerWindow::SONG_LIST_MOD
 {
     // Update the ui since we're showing the dialog.
     ui->addFolderButton->setEnabled(false);
+    ui->addPlaylistButton->setEnabled(false);
 
     // Setup the window and show it.
     if(aSongListMode == SongListViewerWindow::SONG_LIST_MODE::CONFIRM_IMPORTED_SONGS)
@@ -253,6 +388,14 @@ void StartupWindow::updateUi()
     bool enableViewAndSortButtons = !mSongs.empty();
     ui->beginSortingButton->setEnabled(enableViewAndSortButtons);
     ui->viewSongListButton->setEnabled(enableViewAndSortButtons);
+
+    // Ranks can be saved once songs have been sorted, unless they're already being saved.
+    bool hasRankedSongs = false;
+    for(int i = 0; i < mSongs.count() && !hasRankedSongs; i++)
+    {
+        hasRankedSongs = (mSongs[i]->getRank() != UNRANKED);
+    }
+    ui->writeRanksButton->setEnabled(hasRankedSongs && !mTagWriter->isWriting());
     if(mSongs.count() > 0)
     {
         ui->numSongsLabel->show();
@@ -2,18 +2,29 @@
 #define STARTUPWINDOW_H
 
 #include <QDir>
-#include <QDirIterator>
 #include <QFileDialog>
 #include <QList>
 #include <QMainWindow>
 #include <QMediaPlayer>
+#include <QSet>
+#include <QSettings>
+#include <QStandardPaths>
 #include <QString>
-#include <taglib/fileref.h>
-#include <taglib/tag.h>
+#include <QVector>
+#include "mediaHandling/audioanalyzer.h"
+#include "songHandling/directorytraverser.h"
+#include "songHandling/playlistparser.h"
 #include "songHandling/song.h"
+#include "songHandling/songbatch.h"
+#include "songHandling/tagworkerpool.h"
+#include "songHandling/tagwriter.h"
+#include "sorting/preferencestore.h"
 #include "UI/songlistviewerwindow.h"
 #include <UI/comparisonwindow.h>
 
+#define EXCLUDE_PATTERNS_SETTING "excludePatterns"
+#define EXCLUDE_PATTERN_SEPARATOR ';'
+
 namespace Ui {
     class StartupWindow;
 }
@@ -21,6 +32,7 @@ namespace Ui {
 class StartupWindow : public QMainWindow
 {
     Q_OBJECT
+    friend class PerformanceTests;
 
     public:
         explicit StartupWindow(QWidget *parent = 0);
@@ -28,26 +40,42 @@ class StartupWindow : public QMainWindow
 
     private slots:
         void on_addFolderButton_released();
+        void on_addPlaylistButton_released();
         void on_beginSortingButton_released();
+        void on_excludePatternsLineEdit_editingFinished();
         void on_importedSongsConfirmed();
+        void on_resultsWindowClosed();
         void on_SongListViewerWindowCancelled();
         void on_songListEdited();
+        void on_sortingCancelled();
+        void on_sortingFinished();
+        void on_tagWriteProgressChanged(int aNumFinished, int aNumFiles);
+        void on_tagWritingFinished(int aNumFailed);
         void on_viewSongListButton_released();
+        void on_writeRanksButton_released();
 
     private:
+        QStringList getExcludePatterns() const;
+        void importSongFiles(const QStringList& aFilePaths, const QVector<IoScheduler::file_location>& aLocations = QVector<IoScheduler::file_location>());
         void parseNextSong();
         void showSongListViewerWindow(SongListViewerWindow::SONG_LIST_MODE aSongListMode);
         void updateUi();
 
         Ui::StartupWindow *ui;
 
+        AudioAnalyzer* mAudioAnalyzer = nullptr; //!< Analyzes the loudness of imported songs in the background.
         ComparisonWindow* mComparisonWindow = nullptr; //!< The window for comparing pairs of songs.
         SongListViewerWindow* mSongListViewerWindow = nullptr; //!< The window for viewing lists of songs.
+        TagWorkerPool* mTagWorkerPool = nullptr; //!< Reads the tags of imported songs in helper processes.
+        TagWriter* mTagWriter = nullptr; //!< Writes the ranks of sorted songs into their files in the background.
+        SongBatch mImportBatch; //!< Owns the songs that are being imported until they're confirmed or cancelled.
+        SongBatch mLibraryBatch; //!< Owns the songs in the main song list.
+        PreferenceStore mPreferenceStore; //!< The user's answers from every sort, which later sorts reuse.
+        QSettings mSettings; //!< The user's settings, which are kept between sessions.
         QList<Song*> mSongs; //!< The main song list.
         QList<Song*> mSongsFromSelectedFolder; //!< A temporary list of songs from an imported folder.
 
         const static QString mNumSongsLabel; //!< A label for the number of songs in the main song list.
-        static QStringList msSupportedFileExtensions; //!< The file extensions that are searched for in a selected folder.
 };
 
 #endif // STARTUPWINDOW_H
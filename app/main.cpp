@@ -0,0 +1,19 @@
+#include "UI/startupwindow.h"
+#include "songHandling/tagworkerpool.h"
+#include <QApplication>
+#include <cstring>
+
+int main(int argc, char *argv[])
+{
+    // The app is also started as a helper process that parses tags for the TagWorkerPool.
+    if(argc > 1 && std::strcmp(argv[1], TAG_WORKER_ARGUMENT) == 0)
+    {
+        return TagWorkerPool::runWorker();
+    }
+
+    QApplication a(argc, argv);
+    StartupWindow w;
+    w.show();
+
+    return a.exec();
+}
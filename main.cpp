@@ -1,11 +0,0 @@
-#include "UI/startupwindow.h"
-#include <QApplication>
-
-int main(int argc, char *argv[])
-{
-    QApplication a(argc, argv);
-    StartupWindow w;
-    w.show();
-
-    return a.exec();
-}
@@ -0,0 +1,166 @@
+#include "analysisstore.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+/**
+  @class AnalysisStore
+  @ingroup mediaHandling
+  @brief Keeps the results of analyzing song files between sessions.
+
+  Results are keyed by file path and stamped with the size and modification time of the file, so
+  a file that changes after it's analyzed is analyzed again. Results from an older
+  @link ANALYSIS_VERSION version@endlink of the analysis are dropped when the store is loaded.
+
+  The store can be filled in from several threads at once.
+*/
+
+//-----------------------------------------------
+// Static Variable Initialization
+//-----------------------------------------------
+
+static const quint32 ANALYSIS_STORE_MAGIC = 0x53534146; // "SSAF"
+
+//-----------------------------------------------
+// Constructors and Destructor
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for the AnalysisStore.
+ * @param aStorePath The path of the file that the store is loaded from and saved to.
+ */
+AnalysisStore::AnalysisStore(const QString& aStorePath) :
+    mStorePath(aStorePath)
+{}
+
+/**
+ * @brief Destructor for the AnalysisStore.
+ */
+AnalysisStore::~AnalysisStore()
+{}
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Gets the analysis of a file.
+ * @param aFilePath The path of the file.
+ * @param aAnalysis Set to the analysis of the file if it's found.
+ * @return True if the file has been analyzed and hasn't changed since.
+ */
+bool AnalysisStore::getAnalysis(const QString& aFilePath, audio_analysis* aAnalysis) const
+{
+    QFileInfo fileInfo(aFilePath);
+    QMutexLocker locker(&mMutex);
+    QHash<QString, audio_analysis>::const_iterator iter = mAnalyses.constFind(aFilePath);
+    if(iter == mAnalyses.constEnd() || iter->file_size != fileInfo.size() ||
+       iter->modified_time != fileInfo.lastModified().toMSecsSinceEpoch())
+    {
+        return false;
+    }
+    *aAnalysis = *iter;
+    return true;
+}
+
+/**
+ * @brief Adds the analysis of a file to the store.
+ * @param aFilePath The path of the file.
+ * @param aAnalysis The analysis. Its file size and modification time are filled in from the file.
+ */
+void AnalysisStore::insert(const QString& aFilePath, audio_analysis aAnalysis)
+{
+    QFileInfo fileInfo(aFilePath);
+    aAnalysis.version = ANALYSIS_VERSION;
+    aAnalysis.file_size = fileInfo.size();
+    aAnalysis.modified_time = fileInfo.lastModified().toMSecsSinceEpoch();
+
+    QMutexLocker locker(&mMutex);
+    mAnalyses.insert(aFilePath, aAnalysis);
+    mUnsavedChanges = true;
+}
+
+/**
+ * @brief Checks if a file has been analyzed.
+ * @param aFilePath The path of the file.
+ * @return True if the file has been analyzed and hasn't changed since.
+ */
+bool AnalysisStore::isAnalyzed(const QString& aFilePath) const
+{
+    audio_analysis analysis;
+    return getAnalysis(aFilePath, &analysis);
+}
+
+/**
+ * @brief Loads the store from its file.
+ * @return True if the store was loaded. False if the file doesn't exist or is from another version.
+ */
+bool AnalysisStore::load()
+{
+    QFile storeFile(mStorePath);
+    if(!storeFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream stream(&storeFile);
+    quint32 magic = 0;
+    qint32 version = 0;
+    qint32 numAnalyses = 0;
+    stream >> magic >> version >> numAnalyses;
+    if(magic != ANALYSIS_STORE_MAGIC || version != ANALYSIS_VERSION)
+    {
+        return false;
+    }
+
+    QMutexLocker locker(&mMutex);
+    for(int i = 0; i < numAnalyses && stream.status() == QDataStream::Ok; i++)
+    {
+        QString filePath;
+        audio_analysis analysis;
+        stream >> filePath >> analysis.file_size >> analysis.modified_time >> analysis.integrated_loudness >> analysis.replay_gain
+               >> analysis.preview_start >> analysis.preview_length;
+        if(stream.status() == QDataStream::Ok)
+        {
+            mAnalyses.insert(filePath, analysis);
+        }
+    }
+    mUnsavedChanges = false;
+    return true;
+}
+
+/**
+ * @brief Saves the store to its file if it has changed.
+ * @return True if the store is saved.
+ *
+ * The file is replaced atomically, so an interrupted save leaves the previous store in place.
+ */
+bool AnalysisStore::save()
+{
+    QMutexLocker locker(&mMutex);
+    if(!mUnsavedChanges)
+    {
+        return true;
+    }
+
+    QSaveFile storeFile(mStorePath);
+    if(!storeFile.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    QDataStream stream(&storeFile);
+    stream << ANALYSIS_STORE_MAGIC << (qint32)ANALYSIS_VERSION << (qint32)mAnalyses.count();
+    for(QHash<QString, audio_analysis>::const_iterator iter = mAnalyses.constBegin(); iter != mAnalyses.constEnd(); ++iter)
+    {
+        stream << iter.key() << iter->file_size << iter->modified_time << iter->integrated_loudness << iter->replay_gain
+               << iter->preview_start << iter->preview_length;
+    }
+
+    mUnsavedChanges = !storeFile.commit();
+    return !mUnsavedChanges;
+}
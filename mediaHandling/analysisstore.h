@@ -0,0 +1,44 @@
+#ifndef ANALYSISSTORE_H
+#define ANALYSISSTORE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include "mediaHandling/loudnessmeter.h"
+
+#define ANALYSIS_VERSION 2
+
+class AnalysisStore
+{
+    public:
+        /**
+         * @brief The results of analyzing a song file.
+         */
+        typedef struct audio_analysis
+        {
+            int version = ANALYSIS_VERSION; //!< The \link ANALYSIS_VERSION version\endlink of the analysis that produced the results.
+            qint64 file_size = -1; //!< The size of the file when it was analyzed.
+            qint64 modified_time = 0; //!< The last modification time of the file when it was analyzed, in ms since the epoch.
+            double integrated_loudness = SILENCE_LUFS; //!< The integrated loudness of the song in LUFS.
+            double replay_gain = 0.0; //!< The gain in dB that brings the song to the ReplayGain reference loudness.
+            qint64 preview_start = 0; //!< The start of the most representative segment of the song in ms.
+            qint64 preview_length = 0; //!< The length of the most representative segment of the song in ms. 0 if there isn't one.
+        } audio_analysis;
+
+        explicit AnalysisStore(const QString& aStorePath);
+        ~AnalysisStore();
+
+        bool getAnalysis(const QString& aFilePath, audio_analysis* aAnalysis) const;
+        void insert(const QString& aFilePath, audio_analysis aAnalysis);
+        bool isAnalyzed(const QString& aFilePath) const;
+        bool load();
+        bool save();
+
+    private:
+        mutable QMutex mMutex; //!< Guards the store, since it's filled in by worker threads.
+        bool mUnsavedChanges = false; //!< Whether or not results have been added since the store was last saved.
+        QHash<QString, audio_analysis> mAnalyses; //!< The results of each analyzed file, keyed by file path.
+        QString mStorePath; //!< The path of the file that the store is saved to.
+};
+
+#endif // ANALYSISSTORE_H
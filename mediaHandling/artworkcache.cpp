@@ -0,0 +1,317 @@
+#include "artworkcache.h"
+
+#include <string>
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <taglib/attachedpictureframe.h>
+#include <taglib/flacfile.h>
+#include <taglib/flacpicture.h>
+#include <taglib/id3v2tag.h>
+#include <taglib/mpegfile.h>
+
+/**
+  @class ArtworkCache
+  @ingroup mediaHandling
+  @brief Loads downscaled album artwork in the background.
+
+  Decoding the artwork embedded in a song file can take long enough to stall the UI, so the ArtworkCache
+  does all of its loading on a private thread pool and emits @link ArtworkCache::artworkReady artworkReady@endlink
+  when a thumbnail is available.
+
+  Thumbnails are cached per album, so artwork that is shared across an album is only decoded once:
+  @n - In memory, the most recently used thumbnails are kept up to @link MAX_THUMBNAIL_CACHE_KB a size limit@endlink.
+  @n - On disk, every thumbnail that has been decoded is kept in the application's cache directory. An empty
+  file marks an album that has no artwork.
+
+  Prefetched albums wait in a queue of their own and are only given to the thread pool when one of its threads
+  is free. Requested artwork never has to wait behind a backlog of prefetches.
+*/
+
+//-----------------------------------------------
+// Constructors and Destructor
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for the ArtworkCache.
+ * @param parent The parent of the cache.
+ */
+ArtworkCache::ArtworkCache(QObject *parent) :
+    QObject(parent),
+    mThumbnails(MAX_THUMBNAIL_CACHE_KB)
+{
+    mThumbnailDirectory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/thumbnails";
+    QDir().mkpath(mThumbnailDirectory);
+
+    // Reading artwork is mostly waiting on the disk, so a couple of threads is enough.
+    mThreadPool.setMaxThreadCount(2);
+}
+
+/**
+ * @brief Destructor for the ArtworkCache.
+ *
+ * Jobs that haven't started are dropped, and jobs that are running are waited on since they refer to the cache.
+ */
+ArtworkCache::~ArtworkCache()
+{
+    mThreadPool.clear();
+    mThreadPool.waitForDone();
+}
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Gets the key of the album that a song belongs to.
+ * @param aSong The song.
+ * @return A hash of the artist and album name. Songs without an album name are keyed by their file path.
+ */
+QString ArtworkCache::getAlbumKey(const Song* aSong)
+{
+    QString album = aSong->getAlbumName().trimmed().toLower();
+    QString source = album.isEmpty() ? aSong->getFilePath() : aSong->getArtistName().trimmed().toLower() + "\n" + album;
+    return QString(QCryptographicHash::hash(source.toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+/**
+ * @brief Gets the thumbnail of a song's album if it's in memory.
+ * @param aSong The song.
+ * @return The thumbnail, or a null image if it hasn't been loaded or the album has no artwork.
+ */
+QImage ArtworkCache::getCachedArtwork(const Song* aSong) const
+{
+    QImage* thumbnail = mThumbnails.object(getAlbumKey(aSong));
+    return (thumbnail != nullptr) ? *thumbnail : QImage();
+}
+
+/**
+ * @brief Loads the artwork of songs that are likely to be shown soon.
+ * @param aSongs The songs to load the artwork of.
+ *
+ * Prefetching works like @link ArtworkCache::requestArtwork requestArtwork@endlink, except that
+ * requested artwork is loaded first.
+ */
+void ArtworkCache::prefetchArtwork(const QList<const Song*>& aSongs)
+{
+    for(const Song* song : aSongs)
+    {
+        QString albumKey = getAlbumKey(song);
+        if(!mThumbnails.contains(albumKey) && !mAlbumsWithoutArtwork.contains(albumKey) && !mPendingAlbums.contains(albumKey)
+           && !mPrefetchFilePaths.contains(albumKey))
+        {
+            mPrefetchQueue.append(albumKey);
+            mPrefetchFilePaths.insert(albumKey, song->getFilePath());
+        }
+    }
+    startPrefetches();
+}
+
+/**
+ * @brief Loads the artwork of a song's album.
+ * @param aSong The song.
+ *
+ * @link ArtworkCache::artworkReady artworkReady@endlink is emitted once the thumbnail is loaded. If
+ * the thumbnail is already in memory, it is emitted right away.
+ */
+void ArtworkCache::requestArtwork(const Song* aSong)
+{
+    QString albumKey = getAlbumKey(aSong);
+    if(mThumbnails.contains(albumKey))
+    {
+        emit artworkReady(albumKey, *mThumbnails.object(albumKey));
+    }
+    else if(mAlbumsWithoutArtwork.contains(albumKey))
+    {
+        emit artworkReady(albumKey, QImage());
+    }
+    else if(!mPendingAlbums.contains(albumKey))
+    {
+        // If the album is waiting to be prefetched, this request takes its place.
+        if(mPrefetchFilePaths.remove(albumKey) > 0)
+        {
+            mPrefetchQueue.removeOne(albumKey);
+        }
+        mPendingAlbums.insert(albumKey);
+        mThreadPool.start(new ArtworkJob(this, albumKey, aSong->getFilePath(), getThumbnailPath(albumKey)), 1);
+    }
+}
+
+//-----------------------------------------------
+// Slots
+//-----------------------------------------------
+
+/**
+ * @brief Handles a job finishing loading a thumbnail.
+ * @param aAlbumKey The key of the album that the thumbnail belongs to.
+ * @param aThumbnail The thumbnail. This is a null image if the album has no artwork.
+ */
+void ArtworkCache::on_artworkLoaded(QString aAlbumKey, QImage aThumbnail)
+{
+    mPendingAlbums.remove(aAlbumKey);
+    if(aThumbnail.isNull())
+    {
+        mAlbumsWithoutArtwork.insert(aAlbumKey);
+    }
+    else
+    {
+        int costInKb = qMax(1, aThumbnail.width() * aThumbnail.height() * 4 / 1024);
+        mThumbnails.insert(aAlbumKey, new QImage(aThumbnail), costInKb);
+    }
+    emit artworkReady(aAlbumKey, aThumbnail);
+    startPrefetches();
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Gets the path of an album's thumbnail in the disk cache.
+ * @param aAlbumKey The key of the album.
+ * @return The path of the thumbnail file.
+ */
+QString ArtworkCache::getThumbnailPath(const QString& aAlbumKey) const
+{
+    return mThumbnailDirectory + "/" + aAlbumKey + ".jpg";
+}
+
+/**
+ * @brief Gives queued prefetches to the thread pool while it has fewer jobs than threads.
+ *
+ * Each prefetch starts as soon as it's given to the pool, so requested artwork is never queued behind prefetches.
+ */
+void ArtworkCache::startPrefetches()
+{
+    while(!mPrefetchQueue.isEmpty() && mPendingAlbums.count() < mThreadPool.maxThreadCount())
+    {
+        QString albumKey = mPrefetchQueue.takeFirst();
+        mPendingAlbums.insert(albumKey);
+        mThreadPool.start(new ArtworkJob(this, albumKey, mPrefetchFilePaths.take(albumKey), getThumbnailPath(albumKey)), 0);
+    }
+}
+
+//-----------------------------------------------
+// ArtworkJob
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for an ArtworkJob.
+ * @param aCache The cache that receives the thumbnail.
+ * @param aAlbumKey The key of the album that the artwork belongs to.
+ * @param aFilePath The song file to extract the artwork from.
+ * @param aThumbnailPath The path of the thumbnail in the disk cache.
+ */
+ArtworkCache::ArtworkJob::ArtworkJob(ArtworkCache* aCache, QString aAlbumKey, QString aFilePath, QString aThumbnailPath) :
+    mCache(aCache),
+    mAlbumKey(aAlbumKey),
+    mFilePath(aFilePath),
+    mThumbnailPath(aThumbnailPath)
+{}
+
+/**
+ * @brief Loads the thumbnail and hands it to the cache on the cache's thread.
+ */
+void ArtworkCache::ArtworkJob::run()
+{
+    QImage thumbnail;
+    QFileInfo thumbnailInfo(mThumbnailPath);
+    if(thumbnailInfo.exists())
+    {
+        // An empty thumbnail file means that we've already found that the album has no artwork.
+        if(thumbnailInfo.size() > 0)
+        {
+            thumbnail = QImage(mThumbnailPath);
+        }
+    }
+    else
+    {
+        // Decode the artwork straight to thumbnail size. For JPEGs this lets the decoder skip most of the work.
+        QByteArray artwork = extractEmbeddedArtwork(mFilePath);
+        if(!artwork.isEmpty())
+        {
+            QBuffer buffer(&artwork);
+            buffer.open(QIODevice::ReadOnly);
+            QImageReader reader(&buffer);
+            QSize artworkSize = reader.size();
+            if(artworkSize.isValid())
+            {
+                reader.setScaledSize(artworkSize.scaled(THUMBNAIL_SIZE, THUMBNAIL_SIZE, Qt::KeepAspectRatio));
+            }
+            thumbnail = reader.read();
+        }
+
+        // Save the thumbnail to the disk cache. QSaveFile makes sure that a partial thumbnail is never left behind.
+        QSaveFile thumbnailFile(mThumbnailPath);
+        if(thumbnailFile.open(QIODevice::WriteOnly))
+        {
+            if(!thumbnail.isNull())
+            {
+                thumbnail.save(&thumbnailFile, "JPG", 90);
+            }
+            thumbnailFile.commit();
+        }
+    }
+
+    QMetaObject::invokeMethod(mCache, "on_artworkLoaded", Qt::QueuedConnection, Q_ARG(QString, mAlbumKey), Q_ARG(QImage, thumbnail));
+}
+
+/**
+ * @brief Extracts the artwork embedded in a song file.
+ * @param aFilePath The path of the song file.
+ * @return The encoded artwork, or an empty array if the file has none. The front cover is preferred if there is more than one picture.
+ */
+QByteArray ArtworkCache::ArtworkJob::extractEmbeddedArtwork(const QString& aFilePath)
+{
+    QByteArray artwork;
+    QString extension = QFileInfo(aFilePath).suffix().toLower();
+
+    // Taglib takes wide paths on Windows, and paths in the file system's 8-bit encoding everywhere else.
+#ifdef Q_OS_WIN
+    std::wstring filePathForTaglib = aFilePath.toStdWString();
+    TagLib::FileName fileName(filePathForTaglib.c_str());
+#else
+    QByteArray filePathForTaglib = QFile::encodeName(aFilePath);
+    TagLib::FileName fileName(filePathForTaglib.constData());
+#endif
+
+    if(extension == "mp3")
+    {
+        // MP3 files store artwork in ID3v2 APIC frames.
+        TagLib::MPEG::File file(fileName, false);
+        if(file.isValid() && file.ID3v2Tag() != nullptr)
+        {
+            const TagLib::ID3v2::FrameList& frames = file.ID3v2Tag()->frameListMap()["APIC"];
+            for(TagLib::ID3v2::Frame* frame : frames)
+            {
+                TagLib::ID3v2::AttachedPictureFrame* picture = static_cast<TagLib::ID3v2::AttachedPictureFrame*>(frame);
+                if(artwork.isEmpty() || picture->type() == TagLib::ID3v2::AttachedPictureFrame::FrontCover)
+                {
+                    artwork = QByteArray(picture->picture().data(), (int)picture->picture().size());
+                }
+            }
+        }
+    }
+    else if(extension == "flac")
+    {
+        // FLAC files store artwork in PICTURE metadata blocks.
+        TagLib::FLAC::File file(fileName, false);
+        if(file.isValid())
+        {
+            for(TagLib::FLAC::Picture* picture : file.pictureList())
+            {
+                if(artwork.isEmpty() || picture->type() == TagLib::FLAC::Picture::FrontCover)
+                {
+                    artwork = QByteArray(picture->data().data(), (int)picture->data().size());
+                }
+            }
+        }
+    }
+
+    return artwork;
+}
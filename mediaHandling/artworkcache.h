@@ -0,0 +1,73 @@
+#ifndef ARTWORKCACHE_H
+#define ARTWORKCACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QObject>
+#include <QRunnable>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include "songHandling/song.h"
+
+#define THUMBNAIL_SIZE 256
+#define MAX_THUMBNAIL_CACHE_KB (64 * 1024)
+
+class ArtworkCache : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit ArtworkCache(QObject *parent = 0);
+        ~ArtworkCache();
+
+        static QString getAlbumKey(const Song* aSong);
+        QImage getCachedArtwork(const Song* aSong) const;
+        void prefetchArtwork(const QList<const Song*>& aSongs);
+        void requestArtwork(const Song* aSong);
+
+    signals:
+        void artworkReady(QString aAlbumKey, QImage aThumbnail); //!< Emitted when the thumbnail of an album has been loaded. The thumbnail is null if the album has no artwork.
+
+    private slots:
+        void on_artworkLoaded(QString aAlbumKey, QImage aThumbnail);
+
+    private:
+        /**
+         * @brief Loads the thumbnail of an album on a worker thread.
+         *
+         * The thumbnail is read from the disk cache if it's there. Otherwise, the artwork embedded in the song
+         * file is decoded at thumbnail size and written to the disk cache.
+         */
+        class ArtworkJob : public QRunnable
+        {
+            public:
+                ArtworkJob(ArtworkCache* aCache, QString aAlbumKey, QString aFilePath, QString aThumbnailPath);
+                void run() override;
+
+            private:
+                static QByteArray extractEmbeddedArtwork(const QString& aFilePath);
+
+                ArtworkCache* mCache; //!< The cache that receives the thumbnail.
+                QString mAlbumKey; //!< The key of the album that the artwork belongs to.
+                QString mFilePath; //!< The song file to extract the artwork from.
+                QString mThumbnailPath; //!< The path of the thumbnail in the disk cache.
+        };
+
+        QString getThumbnailPath(const QString& aAlbumKey) const;
+        void startPrefetches();
+
+        QCache<QString, QImage> mThumbnails; //!< The least recently used in-memory thumbnails. The cost of each thumbnail is its size in KB.
+        QSet<QString> mAlbumsWithoutArtwork; //!< The albums that are known to have no artwork.
+        QSet<QString> mPendingAlbums; //!< The albums that currently have a job loading their artwork.
+        QHash<QString, QString> mPrefetchFilePaths; //!< The song file to load each queued prefetch from.
+        QStringList mPrefetchQueue; //!< The albums waiting to be prefetched, in the order they were asked for. They don't have a job yet.
+        QString mThumbnailDirectory; //!< The directory of the on-disk thumbnail cache.
+        QThreadPool mThreadPool; //!< The worker threads that load artwork.
+};
+
+#endif // ARTWORKCACHE_H
@@ -0,0 +1,283 @@
+#include "audioanalyzer.h"
+
+#include <QAudioDecoder>
+#include <QAudioFormat>
+#include <QDir>
+#include <QEventLoop>
+#include <QStandardPaths>
+#include <QThread>
+
+/**
+  @class AudioAnalyzer
+  @ingroup mediaHandling
+  @brief Analyzes songs in the background.
+
+  Each song is decoded with QAudioDecoder on a worker thread. The decoded samples are measured with a
+  @link LoudnessMeter LoudnessMeter@endlink and searched for a preview segment with a
+  @link PreviewSegmentDetector PreviewSegmentDetector@endlink in the same pass. The results are kept in an
+  @link AnalysisStore AnalysisStore@endlink so that playback can apply them without any delay.
+
+  Analysis uses every core, but the worker threads run at the lowest priority so that they don't compete
+  with the UI. The store is saved every @link ANALYSIS_SAVE_INTERVAL few results@endlink and when the analyzer
+  is destroyed, and songs that are already in the store are skipped, so analysis picks up where it stopped
+  in the next session.
+*/
+
+//-----------------------------------------------
+// Constructors and Destructor
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for the AudioAnalyzer.
+ * @param parent The parent of the analyzer.
+ *
+ * The results of previous sessions are loaded from the application's data directory.
+ */
+AudioAnalyzer::AudioAnalyzer(QObject *parent) :
+    QObject(parent),
+    mAnalysisStore(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/analysis.dat"),
+    mStopping(false)
+{
+    QDir().mkpath(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation));
+    mAnalysisStore.load();
+    mThreadPool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+/**
+ * @brief Destructor for the AudioAnalyzer.
+ *
+ * Running jobs are stopped, and the results so far are saved.
+ */
+AudioAnalyzer::~AudioAnalyzer()
+{
+    mStopping = true;
+    mThreadPool.clear();
+    mThreadPool.waitForDone();
+    mAnalysisStore.save();
+}
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Queues songs to be analyzed.
+ * @param aSongs The songs to analyze. Songs that are already analyzed or queued are skipped.
+ */
+void AudioAnalyzer::analyzeSongs(const QList<Song*>& aSongs)
+{
+    for(const Song* song : aSongs)
+    {
+        QString filePath = song->getFilePath();
+        if(!mQueuedFiles.contains(filePath))
+        {
+            mQueuedFiles.insert(filePath);
+            mThreadPool.start(new AnalysisJob(this, filePath));
+        }
+    }
+}
+
+/**
+ * @brief Gets the analysis of a song file.
+ * @param aFilePath The path of the song file.
+ * @param aAnalysis Set to the analysis of the file if it's available.
+ * @return True if the file has been analyzed.
+ */
+bool AudioAnalyzer::getAnalysis(const QString& aFilePath, AnalysisStore::audio_analysis* aAnalysis) const
+{
+    return mAnalysisStore.getAnalysis(aFilePath, aAnalysis);
+}
+
+//-----------------------------------------------
+// Slots
+//-----------------------------------------------
+
+/**
+ * @brief Handles a job finishing.
+ * @param aFilePath The song file that the job analyzed.
+ * @param aSucceeded Whether or not a new result was added to the store. False if the song couldn't be analyzed or
+ * had already been analyzed.
+ */
+void AudioAnalyzer::on_analysisFinished(QString aFilePath, bool aSucceeded)
+{
+    mQueuedFiles.remove(aFilePath);
+    if(aSucceeded)
+    {
+        mNumUnsavedResults++;
+        emit songAnalyzed(aFilePath);
+    }
+
+    // Save regularly so that an interrupted session doesn't lose much work.
+    if(mNumUnsavedResults >= ANALYSIS_SAVE_INTERVAL || (mQueuedFiles.isEmpty() && mNumUnsavedResults > 0))
+    {
+        mAnalysisStore.save();
+        mNumUnsavedResults = 0;
+    }
+}
+
+//-----------------------------------------------
+// AnalysisJob
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for an AnalysisJob.
+ * @param aAnalyzer The analyzer that receives the results.
+ * @param aFilePath The song file to analyze.
+ */
+AudioAnalyzer::AnalysisJob::AnalysisJob(AudioAnalyzer* aAnalyzer, QString aFilePath) :
+    mAnalyzer(aAnalyzer),
+    mFilePath(aFilePath)
+{}
+
+/**
+ * @brief Decodes the song and adds its analysis to the store.
+ *
+ * QAudioDecoder delivers its buffers through signals, so the job runs its own event loop until
+ * decoding finishes.
+ */
+void AudioAnalyzer::AnalysisJob::run()
+{
+    QThread::currentThread()->setPriority(QThread::LowestPriority);
+
+    // Skip songs that were analyzed in a previous session. Nothing is added, so the store doesn't need to be saved again.
+    if(mAnalyzer->mAnalysisStore.isAnalyzed(mFilePath))
+    {
+        QMetaObject::invokeMethod(mAnalyzer, "on_analysisFinished", Qt::QueuedConnection, Q_ARG(QString, mFilePath), Q_ARG(bool, false));
+        return;
+    }
+
+    // Ask for floating point samples. The decoder may still give us another format, which is converted.
+    QAudioFormat desiredFormat;
+    desiredFormat.setCodec("audio/pcm");
+    desiredFormat.setSampleType(QAudioFormat::Float);
+    desiredFormat.setSampleSize(32);
+    desiredFormat.setByteOrder(QAudioFormat::LittleEndian);
+
+    QAudioDecoder decoder;
+    decoder.setAudioFormat(desiredFormat);
+    decoder.setSourceFilename(mFilePath);
+
+    // Declare variables.
+    bool decodingDone = false;
+    bool succeeded = true;
+    bool meterInitialized = false;
+    bool samplesMeasured = false;
+    LoudnessMeter meter;
+    PreviewSegmentDetector segmentDetector;
+    QVector<float> samples;
+    QEventLoop eventLoop;
+
+    QObject::connect(&decoder, &QAudioDecoder::bufferReady, [&]()
+    {
+        QAudioBuffer buffer = decoder.read();
+        if(mAnalyzer->mStopping)
+        {
+            succeeded = false;
+            decoder.stop();
+            eventLoop.quit();
+            return;
+        }
+        if(!meterInitialized)
+        {
+            meter.reset(buffer.format().sampleRate(), buffer.format().channelCount());
+            segmentDetector.reset(buffer.format().sampleRate(), buffer.format().channelCount());
+            meterInitialized = true;
+        }
+        if(convertToFloat(buffer, samples))
+        {
+            meter.addFrames(samples.constData(), buffer.frameCount());
+            segmentDetector.addFrames(samples.constData(), buffer.frameCount());
+            samplesMeasured = true;
+        }
+    });
+    QObject::connect(&decoder, &QAudioDecoder::finished, [&]()
+    {
+        decodingDone = true;
+        eventLoop.quit();
+    });
+    QObject::connect(&decoder, qOverload<QAudioDecoder::Error>(&QAudioDecoder::error), [&](QAudioDecoder::Error)
+    {
+        decodingDone = true;
+        succeeded = false;
+        eventLoop.quit();
+    });
+
+    decoder.start();
+    if(!decodingDone)
+    {
+        eventLoop.exec();
+    }
+
+    if(mAnalyzer->mStopping)
+    {
+        return;
+    }
+
+    // If none of the buffers were in a format that could be converted, nothing was measured and there is no result.
+    succeeded = succeeded && samplesMeasured;
+    if(succeeded)
+    {
+        AnalysisStore::audio_analysis analysis;
+        analysis.integrated_loudness = meter.getIntegratedLoudness();
+        analysis.replay_gain = meter.getReplayGain();
+
+        // Silent songs and songs shorter than one gating block have no loudness to correct, and the placeholder
+        // loudness would give them a huge boost, so they're played as they are.
+        if(!meter.hasGatedBlocks())
+        {
+            analysis.replay_gain = 0.0;
+        }
+        segmentDetector.detectSegment(&analysis.preview_start, &analysis.preview_length);
+        mAnalyzer->mAnalysisStore.insert(mFilePath, analysis);
+    }
+    QMetaObject::invokeMethod(mAnalyzer, "on_analysisFinished", Qt::QueuedConnection, Q_ARG(QString, mFilePath), Q_ARG(bool, succeeded));
+}
+
+/**
+ * @brief Converts the samples in a decoded buffer to floating point.
+ * @param aBuffer The decoded buffer.
+ * @param aSamples Filled with the interleaved samples of the buffer, in the range [-1, 1].
+ * @return True if the format of the buffer is supported.
+ */
+bool AudioAnalyzer::AnalysisJob::convertToFloat(const QAudioBuffer& aBuffer, QVector<float>& aSamples)
+{
+    QAudioFormat format = aBuffer.format();
+    int numSamples = aBuffer.sampleCount();
+    aSamples.resize(numSamples);
+    float* output = aSamples.data();
+
+    if(format.sampleType() == QAudioFormat::Float && format.sampleSize() == 32)
+    {
+        const float* input = aBuffer.constData<float>();
+        std::copy(input, input + numSamples, output);
+    }
+    else if(format.sampleType() == QAudioFormat::SignedInt && format.sampleSize() == 16)
+    {
+        const qint16* input = aBuffer.constData<qint16>();
+        for(int i = 0; i < numSamples; i++)
+        {
+            output[i] = input[i] / 32768.0f;
+        }
+    }
+    else if(format.sampleType() == QAudioFormat::SignedInt && format.sampleSize() == 32)
+    {
+        const qint32* input = aBuffer.constData<qint32>();
+        for(int i = 0; i < numSamples; i++)
+        {
+            output[i] = (float)(input[i] / 2147483648.0);
+        }
+    }
+    else if(format.sampleType() == QAudioFormat::UnSignedInt && format.sampleSize() == 8)
+    {
+        const quint8* input = aBuffer.constData<quint8>();
+        for(int i = 0; i < numSamples; i++)
+        {
+            output[i] = (input[i] - 128) / 128.0f;
+        }
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,60 @@
+#ifndef AUDIOANALYZER_H
+#define AUDIOANALYZER_H
+
+#include <atomic>
+#include <QAudioBuffer>
+#include <QList>
+#include <QObject>
+#include <QRunnable>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include "mediaHandling/analysisstore.h"
+#include "mediaHandling/previewsegmentdetector.h"
+#include "songHandling/song.h"
+
+#define ANALYSIS_SAVE_INTERVAL 25
+
+class AudioAnalyzer : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit AudioAnalyzer(QObject *parent = 0);
+        ~AudioAnalyzer();
+
+        void analyzeSongs(const QList<Song*>& aSongs);
+        bool getAnalysis(const QString& aFilePath, AnalysisStore::audio_analysis* aAnalysis) const;
+
+    signals:
+        void songAnalyzed(QString aFilePath); //!< Emitted when a song has been analyzed and its results are available.
+
+    private slots:
+        void on_analysisFinished(QString aFilePath, bool aSucceeded);
+
+    private:
+        /**
+         * @brief Decodes a song file and analyzes it on a worker thread.
+         */
+        class AnalysisJob : public QRunnable
+        {
+            public:
+                AnalysisJob(AudioAnalyzer* aAnalyzer, QString aFilePath);
+                void run() override;
+
+            private:
+                static bool convertToFloat(const QAudioBuffer& aBuffer, QVector<float>& aSamples);
+
+                AudioAnalyzer* mAnalyzer; //!< The analyzer that receives the results.
+                QString mFilePath; //!< The song file to analyze.
+        };
+
+        AnalysisStore mAnalysisStore; //!< The results of every song that has been analyzed.
+        int mNumUnsavedResults = 0; //!< The number of results that have been added since the store was last saved.
+        QSet<QString> mQueuedFiles; //!< The files that are queued or being analyzed.
+        std::atomic<bool> mStopping; //!< Set when the analyzer is being destroyed so that running jobs stop early.
+        QThreadPool mThreadPool; //!< The worker threads that analyze songs.
+};
+
+#endif // AUDIOANALYZER_H
@@ -0,0 +1,297 @@
+#include "loudnessmeter.h"
+
+#include <algorithm>
+#include <cmath>
+
+static const double PI = 3.14159265358979323846;
+
+/**
+  @class LoudnessMeter
+  @ingroup mediaHandling
+  @brief Measures the integrated loudness of decoded audio.
+
+  The LoudnessMeter follows ITU-R BS.1770: the samples are K-weighted, their mean square is taken
+  over 400 ms blocks that overlap by 75%, and the blocks are gated to leave out silence and quiet
+  passages. The result is in LUFS, and the ReplayGain 2.0 gain is derived from it.
+
+  Samples are deinterleaved into one contiguous buffer per channel before they're processed. The
+  filters are recursive, so each channel is filtered in a single tight loop that keeps its state in
+  registers, and the mean square is taken with independent accumulators so that the compiler can
+  vectorize it.
+
+  The mean square of every 100 ms window is kept, since four of them make up a block. They are also
+  available through @link LoudnessMeter::getWindowEnergies getWindowEnergies@endlink for other analysis.
+*/
+
+//-----------------------------------------------
+// Constructors and Destructor
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for the LoudnessMeter.
+ * @param aSampleRate The sample rate of the audio in Hz.
+ * @param aNumChannels The number of channels in the audio.
+ */
+LoudnessMeter::LoudnessMeter(int aSampleRate, int aNumChannels)
+{
+    reset(aSampleRate, aNumChannels);
+}
+
+/**
+ * @brief Destructor for the LoudnessMeter.
+ */
+LoudnessMeter::~LoudnessMeter()
+{}
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Adds samples to the measurement.
+ * @param aInterleavedSamples The samples, with the channels interleaved. They should be in the range [-1, 1].
+ * @param aNumFrames The number of frames. A frame has one sample for each channel.
+ */
+void LoudnessMeter::addFrames(const float* aInterleavedSamples, int aNumFrames)
+{
+    // Deinterleave the samples so that each channel can be processed contiguously.
+    for(int channel = 0; channel < mNumChannels; channel++)
+    {
+        QVector<float>& buffer = mChannelBuffers[channel];
+        buffer.resize(aNumFrames);
+        float* channelSamples = buffer.data();
+        const float* source = aInterleavedSamples + channel;
+        for(int frame = 0; frame < aNumFrames; frame++)
+        {
+            channelSamples[frame] = source[frame * mNumChannels];
+        }
+        filterChannel(channelSamples, aNumFrames, mChannelStates[channel]);
+    }
+
+    // Add the energy of the samples to the windows that they belong to.
+    int frame = 0;
+    while(frame < aNumFrames)
+    {
+        int numFramesInSegment = std::min(aNumFrames - frame, mFramesPerWindow - mFramesInCurrentWindow);
+        for(int channel = 0; channel < mNumChannels; channel++)
+        {
+            mCurrentWindowEnergy += sumOfSquares(mChannelBuffers[channel].constData() + frame, numFramesInSegment);
+        }
+        frame += numFramesInSegment;
+        mFramesInCurrentWindow += numFramesInSegment;
+
+        if(mFramesInCurrentWindow == mFramesPerWindow)
+        {
+            mWindowEnergies.append(mCurrentWindowEnergy / mFramesPerWindow);
+            mCurrentWindowEnergy = 0.0;
+            mFramesInCurrentWindow = 0;
+        }
+    }
+}
+
+/**
+ * @brief Gets the gated loudness of all of the samples that have been added.
+ * @return The integrated loudness in LUFS, or @link SILENCE_LUFS SILENCE_LUFS@endlink if the audio is silent or too short.
+ */
+double LoudnessMeter::getIntegratedLoudness() const
+{
+    QVector<double> blockEnergies = getBlockEnergies();
+
+    // Leave out blocks that are quieter than the absolute gate.
+    double absoluteGate = std::pow(10.0, (SILENCE_LUFS + 0.691) / 10.0);
+    double gatedEnergy = 0.0;
+    int numGatedBlocks = 0;
+    for(double energy : blockEnergies)
+    {
+        if(energy > absoluteGate)
+        {
+            gatedEnergy += energy;
+            numGatedBlocks++;
+        }
+    }
+    if(numGatedBlocks == 0)
+    {
+        return SILENCE_LUFS;
+    }
+
+    // Leave out blocks that are more than 10 LU quieter than the blocks that passed the absolute gate.
+    double relativeGate = gatedEnergy / numGatedBlocks * std::pow(10.0, -10.0 / 10.0);
+    gatedEnergy = 0.0;
+    numGatedBlocks = 0;
+    for(double energy : blockEnergies)
+    {
+        if(energy > absoluteGate && energy > relativeGate)
+        {
+            gatedEnergy += energy;
+            numGatedBlocks++;
+        }
+    }
+
+    return -0.691 + 10.0 * std::log10(gatedEnergy / numGatedBlocks);
+}
+
+/**
+ * @brief Gets the gain that brings the audio to the ReplayGain 2.0 reference loudness.
+ * @return The gain in dB.
+ */
+double LoudnessMeter::getReplayGain() const
+{
+    return REPLAYGAIN_REFERENCE_LUFS - getIntegratedLoudness();
+}
+
+/**
+ * @brief Gets the energy of each 100 ms window of the audio.
+ * @return The mean square of the K-weighted samples in each finished window, summed over the channels.
+ */
+const QVector<double>& LoudnessMeter::getWindowEnergies() const
+{
+    return mWindowEnergies;
+}
+
+/**
+ * @brief Checks whether any of the audio is loud enough to be measured.
+ * @return True if at least one 400 ms block passes the absolute gate. If not, the audio is silent or too short,
+ * and the integrated loudness is only a placeholder.
+ */
+bool LoudnessMeter::hasGatedBlocks() const
+{
+    double absoluteGate = std::pow(10.0, (SILENCE_LUFS + 0.691) / 10.0);
+    for(double energy : getBlockEnergies())
+    {
+        if(energy > absoluteGate)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Clears the measurement and sets up the filters for a new format.
+ * @param aSampleRate The sample rate of the audio in Hz.
+ * @param aNumChannels The number of channels in the audio.
+ */
+void LoudnessMeter::reset(int aSampleRate, int aNumChannels)
+{
+    mNumChannels = std::max(1, aNumChannels);
+    mFramesPerWindow = std::max(1, aSampleRate / LOUDNESS_WINDOWS_PER_SECOND);
+    mFramesInCurrentWindow = 0;
+    mCurrentWindowEnergy = 0.0;
+    mChannelBuffers = QVector<QVector<float>>(mNumChannels);
+    mChannelStates = QVector<channel_state>(mNumChannels);
+    mWindowEnergies.clear();
+
+    // The K-weighting filters from BS.1770 are specified at 48 kHz, so they are redesigned for the actual
+    // sample rate from their analog prototypes.
+    double sampleRate = std::max(1, aSampleRate);
+
+    // Pre-filter: a high shelf of about +4 dB.
+    double frequency = 1681.974450955533;
+    double gain = 3.999843853973347;
+    double q = 0.7071752369554196;
+    double k = std::tan(PI * frequency / sampleRate);
+    double vh = std::pow(10.0, gain / 20.0);
+    double vb = std::pow(vh, 0.4996667741545416);
+    double a0 = 1.0 + k / q + k * k;
+    mPreFilter.b0 = (vh + vb * k / q + k * k) / a0;
+    mPreFilter.b1 = 2.0 * (k * k - vh) / a0;
+    mPreFilter.b2 = (vh - vb * k / q + k * k) / a0;
+    mPreFilter.a1 = 2.0 * (k * k - 1.0) / a0;
+    mPreFilter.a2 = (1.0 - k / q + k * k) / a0;
+
+    // High-pass filter: the revised low-frequency B-weighting curve.
+    frequency = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = std::tan(PI * frequency / sampleRate);
+    a0 = 1.0 + k / q + k * k;
+    mHighPassFilter.b0 = 1.0;
+    mHighPassFilter.b1 = -2.0;
+    mHighPassFilter.b2 = 1.0;
+    mHighPassFilter.a1 = 2.0 * (k * k - 1.0) / a0;
+    mHighPassFilter.a2 = (1.0 - k / q + k * k) / a0;
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Gets the energy of each 400 ms gating block of the audio.
+ * @return The mean energy of each block. Each block is made up of four 100 ms windows, and a new block starts every window.
+ */
+QVector<double> LoudnessMeter::getBlockEnergies() const
+{
+    QVector<double> blockEnergies;
+    for(int i = 0; i + 4 <= mWindowEnergies.count(); i++)
+    {
+        blockEnergies.append((mWindowEnergies[i] + mWindowEnergies[i + 1] + mWindowEnergies[i + 2] + mWindowEnergies[i + 3]) / 4.0);
+    }
+    return blockEnergies;
+}
+
+/**
+ * @brief Applies both K-weighting filters to the samples of one channel in place.
+ * @param aSamples The samples of the channel.
+ * @param aNumSamples The number of samples.
+ * @param aState The filter state of the channel. It's updated so that the next call continues where this one stopped.
+ *
+ * Both filters are applied in the same pass in transposed direct form II, with their state copied
+ * into locals so that the loop doesn't go through memory for it.
+ */
+void LoudnessMeter::filterChannel(float* aSamples, int aNumSamples, channel_state& aState) const
+{
+    const biquad pre = mPreFilter;
+    const biquad high = mHighPassFilter;
+    double preZ1 = aState.pre_filter_z1;
+    double preZ2 = aState.pre_filter_z2;
+    double highZ1 = aState.high_pass_z1;
+    double highZ2 = aState.high_pass_z2;
+
+    for(int i = 0; i < aNumSamples; i++)
+    {
+        double input = aSamples[i];
+        double preOutput = pre.b0 * input + preZ1;
+        preZ1 = pre.b1 * input - pre.a1 * preOutput + preZ2;
+        preZ2 = pre.b2 * input - pre.a2 * preOutput;
+
+        double highOutput = high.b0 * preOutput + highZ1;
+        highZ1 = high.b1 * preOutput - high.a1 * highOutput + highZ2;
+        highZ2 = high.b2 * preOutput - high.a2 * highOutput;
+
+        aSamples[i] = (float)highOutput;
+    }
+
+    aState.pre_filter_z1 = preZ1;
+    aState.pre_filter_z2 = preZ2;
+    aState.high_pass_z1 = highZ1;
+    aState.high_pass_z2 = highZ2;
+}
+
+/**
+ * @brief Gets the sum of the squares of some samples.
+ * @param aSamples The samples.
+ * @param aNumSamples The number of samples.
+ * @return The sum of squares.
+ *
+ * Four independent accumulators are used so that the loop has no dependency between iterations and can be vectorized.
+ */
+double LoudnessMeter::sumOfSquares(const float* aSamples, int aNumSamples)
+{
+    float sum0 = 0.0f;
+    float sum1 = 0.0f;
+    float sum2 = 0.0f;
+    float sum3 = 0.0f;
+    int i = 0;
+    for(; i + 4 <= aNumSamples; i += 4)
+    {
+        sum0 += aSamples[i] * aSamples[i];
+        sum1 += aSamples[i + 1] * aSamples[i + 1];
+        sum2 += aSamples[i + 2] * aSamples[i + 2];
+        sum3 += aSamples[i + 3] * aSamples[i + 3];
+    }
+    for(; i < aNumSamples; i++)
+    {
+        sum0 += aSamples[i] * aSamples[i];
+    }
+    return (double)sum0 + sum1 + sum2 + sum3;
+}
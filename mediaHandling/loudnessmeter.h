@@ -0,0 +1,62 @@
+#ifndef LOUDNESSMETER_H
+#define LOUDNESSMETER_H
+
+#include <QVector>
+
+#define REPLAYGAIN_REFERENCE_LUFS -18.0
+#define SILENCE_LUFS -70.0
+#define LOUDNESS_WINDOWS_PER_SECOND 10
+
+class LoudnessMeter
+{
+    public:
+        explicit LoudnessMeter(int aSampleRate = 44100, int aNumChannels = 2);
+        ~LoudnessMeter();
+
+        void addFrames(const float* aInterleavedSamples, int aNumFrames);
+        double getIntegratedLoudness() const;
+        double getReplayGain() const;
+        const QVector<double>& getWindowEnergies() const;
+        bool hasGatedBlocks() const;
+        void reset(int aSampleRate, int aNumChannels);
+
+    private:
+        /**
+         * @brief The coefficients of a second order IIR filter, normalized so that a0 is 1.
+         */
+        typedef struct biquad
+        {
+            double b0 = 1.0; //!< The feedforward coefficient of the current sample.
+            double b1 = 0.0; //!< The feedforward coefficient of the previous sample.
+            double b2 = 0.0; //!< The feedforward coefficient of the sample before the previous one.
+            double a1 = 0.0; //!< The feedback coefficient of the previous output.
+            double a2 = 0.0; //!< The feedback coefficient of the output before the previous one.
+        } biquad;
+
+        /**
+         * @brief The state of the K-weighting filters for one channel.
+         */
+        typedef struct channel_state
+        {
+            double pre_filter_z1 = 0.0; //!< The first delay element of the pre-filter.
+            double pre_filter_z2 = 0.0; //!< The second delay element of the pre-filter.
+            double high_pass_z1 = 0.0; //!< The first delay element of the high-pass filter.
+            double high_pass_z2 = 0.0; //!< The second delay element of the high-pass filter.
+        } channel_state;
+
+        QVector<double> getBlockEnergies() const;
+        void filterChannel(float* aSamples, int aNumSamples, channel_state& aState) const;
+        static double sumOfSquares(const float* aSamples, int aNumSamples);
+
+        int mFramesInCurrentWindow = 0; //!< The number of frames that have been added to the current window.
+        int mFramesPerWindow = 4410; //!< The number of frames in a 100 ms window.
+        int mNumChannels = 2; //!< The number of interleaved channels.
+        double mCurrentWindowEnergy = 0.0; //!< The sum of squares of the K-weighted samples in the current window.
+        biquad mHighPassFilter; //!< The second stage of K-weighting, which models the ear's insensitivity to low frequencies.
+        biquad mPreFilter; //!< The first stage of K-weighting, which models the acoustic effect of the head.
+        QVector<QVector<float>> mChannelBuffers; //!< Scratch buffers that hold each channel's samples contiguously.
+        QVector<channel_state> mChannelStates; //!< The filter state of each channel.
+        QVector<double> mWindowEnergies; //!< The mean square of each finished 100 ms window, summed over the channels.
+};
+
+#endif // LOUDNESSMETER_H
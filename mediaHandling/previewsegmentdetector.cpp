@@ -0,0 +1,257 @@
+#include "previewsegmentdetector.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+  @class PreviewSegmentDetector
+  @ingroup mediaHandling
+  @brief Finds the most representative segment of a song for previews.
+
+  Intros are rarely what makes someone like a song, so previews start at the segment that is both
+  loud and repeated, which is usually the chorus. The detector works on decoded samples:
+  @n - The audio is mixed down to mono and split into @link NUM_PREVIEW_BANDS a few frequency bands@endlink
+  with one-pole low-pass filters. The energy of each band is summed over each second.
+  @n - The log band energies of each second form a feature vector. Comparing short stripes of these vectors
+  against the rest of the song gives a self-similarity score that is high for sections that repeat.
+  @n - Every @link PREVIEW_LENGTH_SECONDS preview-length@endlink window is scored by its loudness and repetition,
+  and the best one is picked.
+*/
+
+//-----------------------------------------------
+// Static Variable Initialization
+//-----------------------------------------------
+
+static const double BAND_SPLIT_FREQUENCIES[NUM_PREVIEW_BANDS - 1] = { 200.0, 1000.0, 4000.0 };
+static const double PI = 3.14159265358979323846;
+
+//-----------------------------------------------
+// Constructors and Destructor
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for the PreviewSegmentDetector.
+ * @param aSampleRate The sample rate of the audio in Hz.
+ * @param aNumChannels The number of channels in the audio.
+ */
+PreviewSegmentDetector::PreviewSegmentDetector(int aSampleRate, int aNumChannels)
+{
+    reset(aSampleRate, aNumChannels);
+}
+
+/**
+ * @brief Destructor for the PreviewSegmentDetector.
+ */
+PreviewSegmentDetector::~PreviewSegmentDetector()
+{}
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Adds samples to the analysis.
+ * @param aInterleavedSamples The samples, with the channels interleaved.
+ * @param aNumFrames The number of frames. A frame has one sample for each channel.
+ */
+void PreviewSegmentDetector::addFrames(const float* aInterleavedSamples, int aNumFrames)
+{
+    double channelScale = 1.0 / mNumChannels;
+    for(int frame = 0; frame < aNumFrames; frame++)
+    {
+        // Mix the frame down to mono.
+        const float* frameSamples = aInterleavedSamples + frame * mNumChannels;
+        double sample = 0.0;
+        for(int channel = 0; channel < mNumChannels; channel++)
+        {
+            sample += frameSamples[channel];
+        }
+        sample *= channelScale;
+
+        // Split the sample into bands. Each band is the difference between two neighbouring low-pass filters.
+        double lowerOutput = 0.0;
+        for(int band = 0; band < NUM_PREVIEW_BANDS - 1; band++)
+        {
+            mLowPassStates[band] += mLowPassCoefficients[band] * (sample - mLowPassStates[band]);
+            double bandOutput = mLowPassStates[band] - lowerOutput;
+            mCurrentSecond.band_energies[band] += bandOutput * bandOutput;
+            lowerOutput = mLowPassStates[band];
+        }
+        double highOutput = sample - lowerOutput;
+        mCurrentSecond.band_energies[NUM_PREVIEW_BANDS - 1] += highOutput * highOutput;
+
+        mFramesInCurrentSecond++;
+        if(mFramesInCurrentSecond == mSampleRate)
+        {
+            for(int band = 0; band < NUM_PREVIEW_BANDS; band++)
+            {
+                mCurrentSecond.band_energies[band] /= mSampleRate;
+            }
+            mSeconds.append(mCurrentSecond);
+            mCurrentSecond = second_features();
+            mFramesInCurrentSecond = 0;
+        }
+    }
+}
+
+/**
+ * @brief Finds the segment that should be used for previews.
+ * @param aStartMs Set to the start of the segment in ms.
+ * @param aLengthMs Set to the length of the segment in ms. This is 0 if no audio has been added.
+ */
+void PreviewSegmentDetector::detectSegment(qint64* aStartMs, qint64* aLengthMs) const
+{
+    int numSeconds = mSeconds.count();
+    int segmentLength = std::min(PREVIEW_LENGTH_SECONDS, numSeconds);
+    *aStartMs = 0;
+    *aLengthMs = (qint64)segmentLength * 1000;
+    if(numSeconds <= segmentLength)
+    {
+        return;
+    }
+
+    // Build the feature vectors from the log band energies, normalized per band so that every band counts the same.
+    QVector<QVector<double>> features(numSeconds, QVector<double>(NUM_PREVIEW_BANDS));
+    QVector<double> loudness(numSeconds);
+    for(int second = 0; second < numSeconds; second++)
+    {
+        double totalEnergy = 0.0;
+        for(int band = 0; band < NUM_PREVIEW_BANDS; band++)
+        {
+            features[second][band] = std::log10(mSeconds[second].band_energies[band] + 1e-10);
+            totalEnergy += mSeconds[second].band_energies[band];
+        }
+        loudness[second] = 10.0 * std::log10(totalEnergy + 1e-10);
+    }
+    for(int band = 0; band < NUM_PREVIEW_BANDS; band++)
+    {
+        double mean = 0.0;
+        double variance = 0.0;
+        for(int second = 0; second < numSeconds; second++)
+        {
+            mean += features[second][band];
+        }
+        mean /= numSeconds;
+        for(int second = 0; second < numSeconds; second++)
+        {
+            variance += (features[second][band] - mean) * (features[second][band] - mean);
+        }
+        double deviation = std::sqrt(variance / numSeconds);
+        for(int second = 0; second < numSeconds; second++)
+        {
+            features[second][band] = (deviation > 0.0) ? (features[second][band] - mean) / deviation : 0.0;
+        }
+    }
+
+    // Score each second by its loudness relative to the rest of the song and by how much it repeats.
+    QVector<double> repetitionScores = getRepetitionScores(features);
+    double minLoudness = *std::min_element(loudness.constBegin(), loudness.constEnd());
+    double maxLoudness = *std::max_element(loudness.constBegin(), loudness.constEnd());
+    double loudnessRange = maxLoudness - minLoudness;
+    QVector<double> prefixScores(numSeconds + 1, 0.0);
+    for(int second = 0; second < numSeconds; second++)
+    {
+        double energyScore = (loudnessRange > 0.0) ? (loudness[second] - minLoudness) / loudnessRange : 1.0;
+        prefixScores[second + 1] = prefixScores[second] + 0.5 * energyScore + 0.5 * repetitionScores[second];
+    }
+
+    // Pick the window with the best total score.
+    int bestStart = 0;
+    double bestScore = -1.0;
+    for(int start = 0; start + segmentLength <= numSeconds; start++)
+    {
+        double score = prefixScores[start + segmentLength] - prefixScores[start];
+        if(score > bestScore)
+        {
+            bestScore = score;
+            bestStart = start;
+        }
+    }
+    *aStartMs = (qint64)bestStart * 1000;
+}
+
+/**
+ * @brief Clears the analysis and sets it up for a new format.
+ * @param aSampleRate The sample rate of the audio in Hz.
+ * @param aNumChannels The number of channels in the audio.
+ */
+void PreviewSegmentDetector::reset(int aSampleRate, int aNumChannels)
+{
+    mSampleRate = std::max(1, aSampleRate);
+    mNumChannels = std::max(1, aNumChannels);
+    mFramesInCurrentSecond = 0;
+    mCurrentSecond = second_features();
+    mSeconds.clear();
+    for(int band = 0; band < NUM_PREVIEW_BANDS - 1; band++)
+    {
+        mLowPassCoefficients[band] = 1.0 - std::exp(-2.0 * PI * BAND_SPLIT_FREQUENCIES[band] / mSampleRate);
+        mLowPassStates[band] = 0.0;
+    }
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Scores how much each second of a song is repeated elsewhere in the song.
+ * @param aFeatures The normalized feature vector of each second.
+ * @return The repetition score of each second, from 0 to 1.
+ *
+ * A second is compared with every second that is at least a preview length away from it, so that
+ * a section isn't counted as repeating itself. The best match is its score.
+ */
+QVector<double> PreviewSegmentDetector::getRepetitionScores(const QVector<QVector<double>>& aFeatures) const
+{
+    int numSeconds = aFeatures.count();
+    QVector<double> scores(numSeconds, 0.0);
+    for(int first = 0; first < numSeconds; first++)
+    {
+        double bestSimilarity = -1.0;
+        for(int second = 0; second < numSeconds; second++)
+        {
+            if(std::abs(second - first) >= PREVIEW_LENGTH_SECONDS)
+            {
+                bestSimilarity = std::max(bestSimilarity, getStripeSimilarity(aFeatures, first, second));
+            }
+        }
+        scores[first] = (bestSimilarity + 1.0) / 2.0;
+    }
+    return scores;
+}
+
+/**
+ * @brief Compares two stretches of a song.
+ * @param aFeatures The normalized feature vector of each second.
+ * @param aFirst The first second of one stretch.
+ * @param aSecond The first second of the other stretch.
+ * @return The mean cosine similarity of the @link SIMILARITY_STRIPE_LENGTH seconds@endlink in each stretch, from -1 to 1.
+ *
+ * Comparing stretches instead of single seconds makes sure that a match follows the same progression.
+ */
+double PreviewSegmentDetector::getStripeSimilarity(const QVector<QVector<double>>& aFeatures, int aFirst, int aSecond)
+{
+    int numSeconds = aFeatures.count();
+    double totalSimilarity = 0.0;
+    int numCompared = 0;
+    for(int offset = 0; offset < SIMILARITY_STRIPE_LENGTH && aFirst + offset < numSeconds && aSecond + offset < numSeconds; offset++)
+    {
+        const QVector<double>& first = aFeatures[aFirst + offset];
+        const QVector<double>& second = aFeatures[aSecond + offset];
+        double dot = 0.0;
+        double firstNorm = 0.0;
+        double secondNorm = 0.0;
+        for(int band = 0; band < NUM_PREVIEW_BANDS; band++)
+        {
+            dot += first[band] * second[band];
+            firstNorm += first[band] * first[band];
+            secondNorm += second[band] * second[band];
+        }
+        if(firstNorm > 0.0 && secondNorm > 0.0)
+        {
+            totalSimilarity += dot / std::sqrt(firstNorm * secondNorm);
+        }
+        numCompared++;
+    }
+    return (numCompared > 0) ? totalSimilarity / numCompared : 0.0;
+}
@@ -0,0 +1,41 @@
+#ifndef PREVIEWSEGMENTDETECTOR_H
+#define PREVIEWSEGMENTDETECTOR_H
+
+#include <QVector>
+
+#define NUM_PREVIEW_BANDS 4
+#define PREVIEW_LENGTH_SECONDS 20
+#define SIMILARITY_STRIPE_LENGTH 4
+
+class PreviewSegmentDetector
+{
+    public:
+        explicit PreviewSegmentDetector(int aSampleRate = 44100, int aNumChannels = 2);
+        ~PreviewSegmentDetector();
+
+        void addFrames(const float* aInterleavedSamples, int aNumFrames);
+        void detectSegment(qint64* aStartMs, qint64* aLengthMs) const;
+        void reset(int aSampleRate, int aNumChannels);
+
+    private:
+        /**
+         * @brief The features of one second of audio.
+         */
+        typedef struct second_features
+        {
+            double band_energies[NUM_PREVIEW_BANDS] = {}; //!< The mean square of the audio in each frequency band.
+        } second_features;
+
+        QVector<double> getRepetitionScores(const QVector<QVector<double>>& aFeatures) const;
+        static double getStripeSimilarity(const QVector<QVector<double>>& aFeatures, int aFirst, int aSecond);
+
+        int mFramesInCurrentSecond = 0; //!< The number of frames that have been added to the current second.
+        int mNumChannels = 2; //!< The number of interleaved channels.
+        int mSampleRate = 44100; //!< The sample rate of the audio in Hz.
+        double mLowPassCoefficients[NUM_PREVIEW_BANDS - 1]; //!< The coefficients of the one-pole low-pass filters that split the bands.
+        double mLowPassStates[NUM_PREVIEW_BANDS - 1]; //!< The state of each low-pass filter.
+        second_features mCurrentSecond; //!< The features of the second that is being added.
+        QVector<second_features> mSeconds; //!< The features of each finished second.
+};
+
+#endif // PREVIEWSEGMENTDETECTOR_H
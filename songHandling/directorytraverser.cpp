@@ -0,0 +1,194 @@
+#include "directorytraverser.h"
+
+#include <algorithm>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QThread>
+#include "songHandling/tagreader.h"
+
+/**
+  @class DirectoryTraverser
+  @ingroup songHandling
+  @brief Finds the song files in a directory tree.
+
+  Each directory is listed by its own job in a thread pool, so subdirectories are walked concurrently.
+  Listing a directory on a network mount is mostly spent waiting on the server, so the pool uses at least
+  @link MIN_TRAVERSAL_THREADS a few threads@endlink even on machines with fewer cores.
+
+  Symlinks are followed, but every directory is identified by its device and inode (its volume serial
+  number and file index on Windows) before it's queued. A directory that was already reached through
+  another path is skipped, so symlink cycles can't make the walk run forever.
+
+  The @link IoScheduler::file_location location@endlink of each song file is found during the walk, so that
+  importing the files doesn't need another pass over them. Outside Windows, each file is stat'd, which is
+  usually answered from the metadata that listing its directory already cached. On Windows, getting a file's
+  index means opening it, so files only get the volume of their directory and keep their path order.
+
+  Song files are matched with @link TagReader::isSupportedFile TagReader::isSupportedFile@endlink, so their
+  extensions are compared case-insensitively. Files and directories whose names match an
+  @link DirectoryTraverser::setExcludePatterns exclude pattern@endlink are skipped.
+*/
+
+//-----------------------------------------------
+// Constructors and Destructor
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for the DirectoryTraverser.
+ */
+DirectoryTraverser::DirectoryTraverser()
+{
+    mThreadPool.setMaxThreadCount(qMax(QThread::idealThreadCount(), MIN_TRAVERSAL_THREADS));
+}
+
+/**
+ * @brief Destructor for the DirectoryTraverser.
+ */
+DirectoryTraverser::~DirectoryTraverser()
+{
+    mThreadPool.waitForDone();
+}
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Finds the song files in a directory and all of its subdirectories.
+ * @param aRootDirectory The directory to search.
+ * @param aLocations Set to the location of each song file, in the same order as the paths. Can be null.
+ * @return The paths of the song files, sorted.
+ *
+ * This blocks until the whole tree has been walked.
+ */
+QStringList DirectoryTraverser::findSongFiles(const QString& aRootDirectory, QVector<IoScheduler::file_location>* aLocations)
+{
+    mSongFiles.clear();
+    mVisitedDirectories.clear();
+    queueDirectory(QDir(aRootDirectory).absolutePath());
+    mThreadPool.waitForDone();
+
+    // The jobs finish in any order, so sort the results to keep imports predictable.
+    QVector<song_file> songFiles = mSongFiles;
+    mSongFiles.clear();
+    std::sort(songFiles.begin(), songFiles.end(), [](const song_file& aFirst, const song_file& aSecond)
+    {
+        return QString::compare(aFirst.path, aSecond.path, Qt::CaseInsensitive) < 0;
+    });
+
+    QStringList songFilePaths;
+    songFilePaths.reserve(songFiles.count());
+    if(aLocations != nullptr)
+    {
+        aLocations->clear();
+        aLocations->reserve(songFiles.count());
+    }
+    for(const song_file& songFile : songFiles)
+    {
+        songFilePaths.append(songFile.path);
+        if(aLocations != nullptr)
+        {
+            aLocations->append(songFile.location);
+        }
+    }
+    return songFilePaths;
+}
+
+/**
+ * @brief Gets the exclude patterns.
+ * @return The wildcard patterns of the file and directory names that are skipped.
+ */
+QStringList DirectoryTraverser::getExcludePatterns() const
+{
+    return mExcludePatterns;
+}
+
+/**
+ * @brief Sets the exclude patterns.
+ * @param aExcludePatterns Wildcard patterns, such as ".*" or "Podcasts". A file or directory whose name matches
+ * any of them is skipped. Patterns are matched case-insensitively.
+ */
+void DirectoryTraverser::setExcludePatterns(const QStringList& aExcludePatterns)
+{
+    mExcludePatterns = aExcludePatterns;
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Queues a directory to be listed if it hasn't been visited yet.
+ * @param aDirectoryPath The path of the directory.
+ */
+void DirectoryTraverser::queueDirectory(const QString& aDirectoryPath)
+{
+    IoScheduler::file_location location;
+    if(!IoScheduler::getFileLocation(aDirectoryPath, &location))
+    {
+        return;
+    }
+    file_id directoryId(location.device, location.inode);
+
+    QMutexLocker locker(&mMutex);
+    if(!mVisitedDirectories.contains(directoryId))
+    {
+        mVisitedDirectories.insert(directoryId);
+        mThreadPool.start(new DirectoryJob(this, aDirectoryPath, directoryId.first));
+    }
+}
+
+//-----------------------------------------------
+// DirectoryJob
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for a DirectoryJob.
+ * @param aTraverser The traverser that receives the results.
+ * @param aDirectoryPath The directory to list.
+ * @param aDevice The device that the directory is on.
+ */
+DirectoryTraverser::DirectoryJob::DirectoryJob(DirectoryTraverser* aTraverser, QString aDirectoryPath, quint64 aDevice) :
+    mTraverser(aTraverser),
+    mDirectoryPath(aDirectoryPath),
+    mDevice(aDevice)
+{}
+
+/**
+ * @brief Lists the directory, adds its song files and their locations to the results and queues its subdirectories.
+ */
+void DirectoryTraverser::DirectoryJob::run()
+{
+    QVector<song_file> songFiles;
+    QFileInfoList entries = QDir(mDirectoryPath).entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System);
+    for(const QFileInfo& entry : entries)
+    {
+        if(QDir::match(mTraverser->mExcludePatterns, entry.fileName()))
+        {
+            continue;
+        }
+
+        if(entry.isDir())
+        {
+            mTraverser->queueDirectory(entry.absoluteFilePath());
+        }
+        else if(TagReader::isSupportedFile(entry.fileName()))
+        {
+            song_file songFile;
+            songFile.path = entry.absoluteFilePath();
+#ifdef Q_OS_WIN
+            songFile.location.device = mDevice;
+#else
+            if(!IoScheduler::getFileLocation(songFile.path, &songFile.location))
+            {
+                songFile.location.device = mDevice;
+            }
+#endif
+            songFiles.append(songFile);
+        }
+    }
+
+    QMutexLocker locker(&mTraverser->mMutex);
+    mTraverser->mSongFiles += songFiles;
+}
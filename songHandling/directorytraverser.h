@@ -0,0 +1,65 @@
+#ifndef DIRECTORYTRAVERSER_H
+#define DIRECTORYTRAVERSER_H
+
+#include <QMutex>
+#include <QPair>
+#include <QRunnable>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include "songHandling/ioscheduler.h"
+
+#define MIN_TRAVERSAL_THREADS 8
+
+class DirectoryTraverser
+{
+    public:
+        DirectoryTraverser();
+        ~DirectoryTraverser();
+
+        QStringList findSongFiles(const QString& aRootDirectory, QVector<IoScheduler::file_location>* aLocations = nullptr);
+        QStringList getExcludePatterns() const;
+        void setExcludePatterns(const QStringList& aExcludePatterns);
+
+    private:
+        /**
+         * @brief Identifies a directory independently of the path that leads to it.
+         */
+        typedef QPair<quint64, quint64> file_id;
+
+        /**
+         * @brief A song file that was found, and where it's stored.
+         */
+        typedef struct song_file
+        {
+            QString path; //!< The path of the file.
+            IoScheduler::file_location location; //!< Where the file is stored.
+        } song_file;
+
+        /**
+         * @brief Lists one directory on a worker thread and queues its subdirectories.
+         */
+        class DirectoryJob : public QRunnable
+        {
+            public:
+                DirectoryJob(DirectoryTraverser* aTraverser, QString aDirectoryPath, quint64 aDevice);
+                void run() override;
+
+            private:
+                DirectoryTraverser* mTraverser; //!< The traverser that receives the results.
+                QString mDirectoryPath; //!< The directory to list.
+                quint64 mDevice; //!< The device that the directory is on.
+        };
+
+        void queueDirectory(const QString& aDirectoryPath);
+
+        QStringList mExcludePatterns; //!< Files and directories whose names match any of these wildcard patterns are skipped.
+        QMutex mMutex; //!< Guards the results and the visited directories, since they're filled in by worker threads.
+        QVector<song_file> mSongFiles; //!< The song files found so far.
+        QThreadPool mThreadPool; //!< The worker threads that list directories.
+        QSet<file_id> mVisitedDirectories; //!< The directories that have already been queued, so that symlink cycles are only walked once.
+};
+
+#endif // DIRECTORYTRAVERSER_H
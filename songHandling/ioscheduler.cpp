@@ -0,0 +1,229 @@
+#include "ioscheduler.h"
+
+#include <algorithm>
+#include <QDir>
+#include <QFile>
+#include <QThread>
+#include <QThreadPool>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+  @class IoScheduler
+  @ingroup songHandling
+  @brief Plans the order in which song files are read during an import.
+
+  Reading tags only touches a small part of each file, so on hard drives and network shares an import is
+  dominated by seeking from one file to the next. The scheduler makes those reads as sequential as it can:
+  @n - Files are @link IoScheduler::getReadOrder ordered@endlink by device, and then by inode (file index on
+  Windows), since file systems tend to allocate neighbouring inodes close together.
+  @n - Shortly before a file is read, the kernel is @link IoScheduler::adviseTagRegions told@endlink to read
+  ahead its first @link TAG_HEADER_REGION_SIZE few hundred KB@endlink, where ID3v2 tags and FLAC metadata live,
+  and its last @link TAG_TRAILER_REGION_SIZE few KB@endlink, where ID3v1 and APE tags live. Where that isn't
+  supported, this does nothing.
+
+  Every lookup is a round trip to the server on a network share, so none of them are made on the GUI thread. The
+  @link DirectoryTraverser DirectoryTraverser@endlink finds the locations of the files while it walks a folder,
+  and the read-ahead hints are @link IoScheduler::adviseTagRegionsInBackground given@endlink on worker threads.
+  @n - The @link TagWorkerPool TagWorkerPool@endlink keeps at most @link MAX_READS_PER_DEVICE a few reads@endlink
+  in flight on each device, so that parallel workers don't make a single disk seek back and forth.
+*/
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Asks the kernel to start reading the parts of a file that hold its tags.
+ * @param aFilePath The path of the file.
+ *
+ * This returns right away. The data is read in the background and is in the page cache when the tags are parsed.
+ */
+void IoScheduler::adviseTagRegions(const QString& aFilePath)
+{
+#ifdef Q_OS_LINUX
+    int fileDescriptor = open(QFile::encodeName(aFilePath).constData(), O_RDONLY | O_CLOEXEC);
+    if(fileDescriptor < 0)
+    {
+        return;
+    }
+    struct stat fileStatus;
+    if(fstat(fileDescriptor, &fileStatus) == 0)
+    {
+        posix_fadvise(fileDescriptor, 0, TAG_HEADER_REGION_SIZE, POSIX_FADV_WILLNEED);
+        if(fileStatus.st_size > TAG_HEADER_REGION_SIZE)
+        {
+            posix_fadvise(fileDescriptor, fileStatus.st_size - TAG_TRAILER_REGION_SIZE, TAG_TRAILER_REGION_SIZE, POSIX_FADV_WILLNEED);
+        }
+    }
+    close(fileDescriptor);
+#else
+    Q_UNUSED(aFilePath);
+#endif
+}
+
+/**
+ * @brief Asks the kernel to start reading the parts of several files that hold their tags, on a worker thread.
+ * @param aThreadPool The thread pool that runs the job. It belongs to the caller.
+ * @param aFilePaths The paths of the files.
+ *
+ * Opening a file on a network share waits on the server, so this keeps the calling thread from waiting.
+ */
+void IoScheduler::adviseTagRegionsInBackground(QThreadPool* aThreadPool, const QStringList& aFilePaths)
+{
+#ifdef Q_OS_LINUX
+    if(!aFilePaths.isEmpty())
+    {
+        aThreadPool->start(new AdviceJob(aFilePaths));
+    }
+#else
+    Q_UNUSED(aThreadPool);
+    Q_UNUSED(aFilePaths);
+#endif
+}
+
+/**
+ * @brief Finds where a file or directory is stored, following symlinks.
+ * @param aFilePath The path of the file or directory.
+ * @param aLocation Set to the location of the file. Together, its device and inode identify the file
+ * independently of the path that leads to it.
+ * @return True if the location could be read.
+ *
+ * Outside Windows, this only stats the file, which is usually answered from the metadata that listing its
+ * folder already cached. Windows needs a handle to the file to get its index.
+ */
+bool IoScheduler::getFileLocation(const QString& aFilePath, file_location* aLocation)
+{
+#ifdef Q_OS_WIN
+    HANDLE handle = CreateFileW((const wchar_t*)QDir::toNativeSeparators(aFilePath).utf16(), 0,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if(handle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    BY_HANDLE_FILE_INFORMATION fileInformation;
+    bool succeeded = GetFileInformationByHandle(handle, &fileInformation);
+    CloseHandle(handle);
+    if(!succeeded)
+    {
+        return false;
+    }
+    aLocation->device = fileInformation.dwVolumeSerialNumber;
+    aLocation->inode = ((quint64)fileInformation.nFileIndexHigh << 32) | fileInformation.nFileIndexLow;
+    return true;
+#else
+    struct stat fileStatus;
+    if(stat(QFile::encodeName(aFilePath).constData(), &fileStatus) != 0)
+    {
+        return false;
+    }
+    aLocation->device = (quint64)fileStatus.st_dev;
+    aLocation->inode = (quint64)fileStatus.st_ino;
+    return true;
+#endif
+}
+
+/**
+ * @brief Finds where several files are stored.
+ * @param aFilePaths The paths of the files.
+ * @return The location of each file. Files whose location couldn't be read get a default location.
+ *
+ * The lookups are spread over several threads, since each one mostly waits on the file system.
+ */
+QVector<IoScheduler::file_location> IoScheduler::getFileLocations(const QStringList& aFilePaths)
+{
+    QVector<file_location> locations(aFilePaths.count());
+    file_location* locationData = locations.data();
+    QThreadPool threadPool;
+    threadPool.setMaxThreadCount(qMax(QThread::idealThreadCount(), MAX_READS_PER_DEVICE));
+    for(int first = 0; first < aFilePaths.count(); first += FILES_PER_LOCATION_JOB)
+    {
+        threadPool.start(new LocationJob(&aFilePaths, locationData, first, qMin(first + FILES_PER_LOCATION_JOB, aFilePaths.count())));
+    }
+    threadPool.waitForDone();
+    return locations;
+}
+
+/**
+ * @brief Orders files so that each device is read as sequentially as possible.
+ * @param aLocations The locations of the files.
+ * @return The indices of the files in the order they should be read.
+ */
+QVector<int> IoScheduler::getReadOrder(const QVector<file_location>& aLocations)
+{
+    QVector<int> order(aLocations.count());
+    for(int i = 0; i < order.count(); i++)
+    {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int aFirst, int aSecond)
+    {
+        const file_location& first = aLocations[aFirst];
+        const file_location& second = aLocations[aSecond];
+        if(first.device != second.device)
+        {
+            return first.device < second.device;
+        }
+        return first.inode < second.inode;
+    });
+    return order;
+}
+
+//-----------------------------------------------
+// AdviceJob
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for an AdviceJob.
+ * @param aFilePaths The paths of the files.
+ */
+IoScheduler::AdviceJob::AdviceJob(QStringList aFilePaths) :
+    mFilePaths(aFilePaths)
+{}
+
+/**
+ * @brief Tells the kernel to read ahead the tags of each file.
+ */
+void IoScheduler::AdviceJob::run()
+{
+    for(const QString& filePath : mFilePaths)
+    {
+        adviseTagRegions(filePath);
+    }
+}
+
+//-----------------------------------------------
+// LocationJob
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for a LocationJob.
+ * @param aFilePaths The paths of all of the files.
+ * @param aLocations The locations of all of the files. The job fills in its range.
+ * @param aFirst The index of the first file in the range.
+ * @param aLast The index after the last file in the range.
+ */
+IoScheduler::LocationJob::LocationJob(const QStringList* aFilePaths, file_location* aLocations, int aFirst, int aLast) :
+    mFilePaths(aFilePaths),
+    mLocations(aLocations),
+    mFirst(aFirst),
+    mLast(aLast)
+{}
+
+/**
+ * @brief Looks up the locations of the files in the range.
+ */
+void IoScheduler::LocationJob::run()
+{
+    for(int i = mFirst; i < mLast; i++)
+    {
+        getFileLocation(mFilePaths->at(i), &mLocations[i]);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef IOSCHEDULER_H
+#define IOSCHEDULER_H
+
+#include <QRunnable>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+#define TAG_HEADER_REGION_SIZE (256 * 1024)
+#define TAG_TRAILER_REGION_SIZE (8 * 1024)
+#define MAX_READS_PER_DEVICE 4
+#define READAHEAD_DEPTH 16
+#define FILES_PER_LOCATION_JOB 256
+
+class IoScheduler
+{
+    public:
+        /**
+         * @brief Where a file is stored.
+         */
+        typedef struct file_location
+        {
+            quint64 device = 0; //!< The device that the file is on.
+            quint64 inode = 0; //!< The inode of the file, or its file index on Windows. 0 if it isn't known, in which case files keep their path order.
+        } file_location;
+
+        static void adviseTagRegions(const QString& aFilePath);
+        static void adviseTagRegionsInBackground(QThreadPool* aThreadPool, const QStringList& aFilePaths);
+        static bool getFileLocation(const QString& aFilePath, file_location* aLocation);
+        static QVector<file_location> getFileLocations(const QStringList& aFilePaths);
+        static QVector<int> getReadOrder(const QVector<file_location>& aLocations);
+
+    private:
+        /**
+         * @brief Tells the kernel to read ahead the tags of some files on a worker thread.
+         */
+        class AdviceJob : public QRunnable
+        {
+            public:
+                explicit AdviceJob(QStringList aFilePaths);
+                void run() override;
+
+            private:
+                QStringList mFilePaths; //!< The paths of the files.
+        };
+
+        /**
+         * @brief Looks up the locations of a range of files on a worker thread.
+         */
+        class LocationJob : public QRunnable
+        {
+            public:
+                LocationJob(const QStringList* aFilePaths, file_location* aLocations, int aFirst, int aLast);
+                void run() override;
+
+            private:
+                const QStringList* mFilePaths; //!< The paths of all of the files.
+                file_location* mLocations; //!< The locations of all of the files.
+                int mFirst; //!< The index of the first file in the range.
+                int mLast; //!< The index after the last file in the range.
+        };
+};
+
+#endif // IOSCHEDULER_H
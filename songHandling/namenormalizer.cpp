@@ -0,0 +1,310 @@
+#include "namenormalizer.h"
+
+#include <QRegularExpression>
+
+/**
+  @class NameNormalizer
+  @ingroup songHandling
+  @brief Turns artist and album names into integer keys for grouping.
+
+  Tags are rarely consistent, so names are normalized before they're compared:
+  @n - Names are decomposed, and accents and other combining marks are dropped, so "Beyoncé" matches "Beyonce".
+  @n - Names are case folded, punctuation is treated as spaces, and runs of spaces are collapsed.
+  @n - A leading @link NameNormalizer::msArticles article@endlink is dropped, as is one moved to the end after
+  a comma, so "The Beatles", "Beatles, The" and "the beatles " all match.
+  @n - Featured artists are split off of the artist, so "Artist feat. Guest" is grouped with "Artist".
+
+  Each distinct raw string is only normalized the first time it's seen. After that, getting its key is a
+  single hash lookup, so grouping and deduplicating songs only needs integer comparisons. Albums are keyed
+  by their main artist and their normalized name, so albums with the same title by different artists stay apart.
+*/
+
+//-----------------------------------------------
+// Static Variable Initialization
+//-----------------------------------------------
+
+const QStringList NameNormalizer::msArticles = QStringList() << "the" << "a" << "an";
+
+static const QRegularExpression TRAILING_ARTICLE_PATTERN(",\\s*(" + NameNormalizer::msArticles.join('|') + ")\\s*$",
+                                                          QRegularExpression::CaseInsensitiveOption);
+static const QRegularExpression FEATURING_PATTERN("[\\(\\[]?\\s*\\b(feat\\.?|ft\\.?|featuring)\\s+",
+                                                  QRegularExpression::CaseInsensitiveOption);
+static const QRegularExpression FEATURED_ARTIST_SEPARATOR_PATTERN("\\s*(,|&|\\band\\b)\\s*",
+                                                                  QRegularExpression::CaseInsensitiveOption);
+
+//-----------------------------------------------
+// Constructors and Destructor
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for the NameNormalizer.
+ */
+NameNormalizer::NameNormalizer()
+{}
+
+/**
+ * @brief Destructor for the NameNormalizer.
+ */
+NameNormalizer::~NameNormalizer()
+{}
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Forgets every name and key.
+ */
+void NameNormalizer::clear()
+{
+    mArtistCredits.clear();
+    mArtistKeys.clear();
+    mArtistNames.clear();
+    mAlbumKeys.clear();
+    mAlbumNameIds.clear();
+    mAlbumNames.clear();
+    mRawAlbumNameIds.clear();
+}
+
+/**
+ * @brief Gets the key of an album.
+ * @param aArtistName The raw name of the artist of the album.
+ * @param aAlbumName The raw name of the album.
+ * @return The key of the album, or NO_GROUP_KEY if the album has no name.
+ */
+int NameNormalizer::getAlbumKey(const QString& aArtistName, const QString& aAlbumName)
+{
+    // Find the id of the album's normalized name, normalizing it if it hasn't been seen before.
+    QHash<QString, int>::const_iterator rawIter = mRawAlbumNameIds.constFind(aAlbumName);
+    int albumNameId = NO_GROUP_KEY;
+    if(rawIter != mRawAlbumNameIds.constEnd())
+    {
+        albumNameId = *rawIter;
+    }
+    else
+    {
+        QString normalizedAlbumName = normalizeName(aAlbumName);
+        if(!normalizedAlbumName.isEmpty())
+        {
+            albumNameId = mAlbumNameIds.value(normalizedAlbumName, mAlbumNameIds.count());
+            mAlbumNameIds.insert(normalizedAlbumName, albumNameId);
+        }
+        mRawAlbumNameIds.insert(aAlbumName, albumNameId);
+    }
+    if(albumNameId == NO_GROUP_KEY)
+    {
+        return NO_GROUP_KEY;
+    }
+
+    QPair<int, int> albumId(getArtistKey(aArtistName), albumNameId);
+    QHash<QPair<int, int>, int>::const_iterator albumIter = mAlbumKeys.constFind(albumId);
+    if(albumIter != mAlbumKeys.constEnd())
+    {
+        return *albumIter;
+    }
+    int albumKey = mAlbumNames.count();
+    mAlbumKeys.insert(albumId, albumKey);
+    mAlbumNames.append(aAlbumName.trimmed());
+    return albumKey;
+}
+
+/**
+ * @brief Gets the key of a song's album.
+ * @param aSong The song.
+ * @return The key of the album, or NO_GROUP_KEY if the song has no album.
+ */
+int NameNormalizer::getAlbumKey(const Song* aSong)
+{
+    return getAlbumKey(aSong->getArtistName(), aSong->getAlbumName());
+}
+
+/**
+ * @brief Gets the name of an album.
+ * @param aAlbumKey The key of the album.
+ * @return The name of the album as it was first seen.
+ */
+QString NameNormalizer::getAlbumName(int aAlbumKey) const
+{
+    return mAlbumNames.value(aAlbumKey);
+}
+
+/**
+ * @brief Gets the key of the main artist in an artist string.
+ * @param aArtistName The raw artist string. Featured artists are ignored.
+ * @return The key of the artist, or NO_GROUP_KEY if there is no artist.
+ */
+int NameNormalizer::getArtistKey(const QString& aArtistName)
+{
+    return getArtistCredit(aArtistName).primary_key;
+}
+
+/**
+ * @brief Gets the key of a song's main artist.
+ * @param aSong The song.
+ * @return The key of the artist, or NO_GROUP_KEY if the song has no artist.
+ */
+int NameNormalizer::getArtistKey(const Song* aSong)
+{
+    return getArtistKey(aSong->getArtistName());
+}
+
+/**
+ * @brief Gets the name of an artist.
+ * @param aArtistKey The key of the artist.
+ * @return The name of the artist as it was first seen.
+ */
+QString NameNormalizer::getArtistName(int aArtistKey) const
+{
+    return mArtistNames.value(aArtistKey);
+}
+
+/**
+ * @brief Gets the keys of the featured artists in an artist string.
+ * @param aArtistName The raw artist string.
+ * @return The keys of the featured artists, in the order they're credited.
+ */
+QVector<int> NameNormalizer::getFeaturedArtistKeys(const QString& aArtistName)
+{
+    return getArtistCredit(aArtistName).featured_keys;
+}
+
+/**
+ * @brief Gets the number of distinct albums that have been seen.
+ * @return The number of album keys.
+ */
+int NameNormalizer::getNumAlbums() const
+{
+    return mAlbumNames.count();
+}
+
+/**
+ * @brief Gets the number of distinct artists that have been seen.
+ * @return The number of artist keys.
+ */
+int NameNormalizer::getNumArtists() const
+{
+    return mArtistNames.count();
+}
+
+/**
+ * @brief Normalizes a name so that different spellings of it can be compared.
+ * @param aName The name.
+ * @return The normalized name. This is empty if the name has no letters or numbers.
+ */
+QString NameNormalizer::normalizeName(const QString& aName)
+{
+    // Drop an article that was moved to the end, like in "Beatles, The".
+    QString name = aName;
+    name.remove(TRAILING_ARTICLE_PATTERN);
+
+    // Drop combining marks after decomposing, and turn everything that isn't a letter or number into a space.
+    QString decomposedName = name.normalized(QString::NormalizationForm_KD);
+    QString normalizedName;
+    normalizedName.reserve(decomposedName.length());
+    for(const QChar& character : decomposedName)
+    {
+        QChar::Category category = character.category();
+        if(category == QChar::Mark_NonSpacing || category == QChar::Mark_SpacingCombining || category == QChar::Mark_Enclosing)
+        {
+            continue;
+        }
+        normalizedName.append(character.isLetterOrNumber() ? character : QChar(' '));
+    }
+    normalizedName = normalizedName.toCaseFolded().simplified();
+
+    // Drop a leading article, unless it's the whole name.
+    for(const QString& article : msArticles)
+    {
+        if(normalizedName.length() > article.length() + 1 && normalizedName.startsWith(article + ' '))
+        {
+            normalizedName.remove(0, article.length() + 1);
+            break;
+        }
+    }
+    return normalizedName;
+}
+
+/**
+ * @brief Splits an artist string into the artists that it credits.
+ * @param aArtistName The raw artist string, such as "Artist feat. Guest & Other Guest".
+ * @return The main artist followed by the featured artists. The main artist itself isn't split, so
+ * duos like "Simon & Garfunkel" stay together.
+ */
+QStringList NameNormalizer::splitArtists(const QString& aArtistName)
+{
+    QStringList artists;
+    QRegularExpressionMatch match = FEATURING_PATTERN.match(aArtistName);
+    if(!match.hasMatch())
+    {
+        artists.append(aArtistName.trimmed());
+        return artists;
+    }
+
+    artists.append(aArtistName.left(match.capturedStart()).trimmed());
+    QString featuredArtists = aArtistName.mid(match.capturedEnd());
+    featuredArtists.remove(')');
+    featuredArtists.remove(']');
+    for(const QString& featuredArtist : featuredArtists.split(FEATURED_ARTIST_SEPARATOR_PATTERN))
+    {
+        if(!featuredArtist.trimmed().isEmpty())
+        {
+            artists.append(featuredArtist.trimmed());
+        }
+    }
+    return artists;
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Gets the artists credited in a raw artist string, splitting and normalizing it if it hasn't been seen before.
+ * @param aArtistName The raw artist string.
+ * @return The keys of the credited artists.
+ */
+const NameNormalizer::artist_credit& NameNormalizer::getArtistCredit(const QString& aArtistName)
+{
+    QHash<QString, artist_credit>::const_iterator iter = mArtistCredits.constFind(aArtistName);
+    if(iter != mArtistCredits.constEnd())
+    {
+        return *iter;
+    }
+
+    artist_credit credit;
+    QStringList artists = splitArtists(aArtistName);
+    credit.primary_key = internArtist(artists.first());
+    for(int i = 1; i < artists.count(); i++)
+    {
+        int featuredKey = internArtist(artists[i]);
+        if(featuredKey != NO_GROUP_KEY && featuredKey != credit.primary_key && !credit.featured_keys.contains(featuredKey))
+        {
+            credit.featured_keys.append(featuredKey);
+        }
+    }
+    return *mArtistCredits.insert(aArtistName, credit);
+}
+
+/**
+ * @brief Gets the key of a single artist, giving it a new key if it hasn't been seen before.
+ * @param aArtistName The raw name of one artist.
+ * @return The key of the artist, or NO_GROUP_KEY if the name has no letters or numbers.
+ */
+int NameNormalizer::internArtist(const QString& aArtistName)
+{
+    QString normalizedArtistName = normalizeName(aArtistName);
+    if(normalizedArtistName.isEmpty())
+    {
+        return NO_GROUP_KEY;
+    }
+
+    QHash<QString, int>::const_iterator iter = mArtistKeys.constFind(normalizedArtistName);
+    if(iter != mArtistKeys.constEnd())
+    {
+        return *iter;
+    }
+    int artistKey = mArtistNames.count();
+    mArtistKeys.insert(normalizedArtistName, artistKey);
+    mArtistNames.append(aArtistName);
+    return artistKey;
+}
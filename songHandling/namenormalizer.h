@@ -0,0 +1,57 @@
+#ifndef NAMENORMALIZER_H
+#define NAMENORMALIZER_H
+
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "songHandling/song.h"
+
+#define NO_GROUP_KEY -1
+
+class NameNormalizer
+{
+    public:
+        NameNormalizer();
+        ~NameNormalizer();
+
+        void clear();
+        int getAlbumKey(const QString& aArtistName, const QString& aAlbumName);
+        int getAlbumKey(const Song* aSong);
+        QString getAlbumName(int aAlbumKey) const;
+        int getArtistKey(const QString& aArtistName);
+        int getArtistKey(const Song* aSong);
+        QString getArtistName(int aArtistKey) const;
+        QVector<int> getFeaturedArtistKeys(const QString& aArtistName);
+        int getNumAlbums() const;
+        int getNumArtists() const;
+
+        static QString normalizeName(const QString& aName);
+        static QStringList splitArtists(const QString& aArtistName);
+
+        static const QStringList msArticles; //!< The articles that are ignored at the start of a name, or at the end after a comma.
+
+    private:
+        /**
+         * @brief The keys of the artists credited in a raw artist string.
+         */
+        typedef struct artist_credit
+        {
+            int primary_key = NO_GROUP_KEY; //!< The key of the main artist.
+            QVector<int> featured_keys; //!< The keys of the featured artists.
+        } artist_credit;
+
+        const artist_credit& getArtistCredit(const QString& aArtistName);
+        int internArtist(const QString& aArtistName);
+
+        QHash<QString, artist_credit> mArtistCredits; //!< The artists credited in each raw artist string that has been seen.
+        QHash<QString, int> mArtistKeys; //!< The key of each normalized artist name.
+        QStringList mArtistNames; //!< The display name of each artist key. This is the first raw name that was seen for the artist.
+        QHash<QPair<int, int>, int> mAlbumKeys; //!< The key of each album, keyed by its artist key and the id of its normalized name.
+        QHash<QString, int> mAlbumNameIds; //!< The id of each normalized album name.
+        QStringList mAlbumNames; //!< The display name of each album key.
+        QHash<QString, int> mRawAlbumNameIds; //!< The id of the normalized name of each raw album string that has been seen.
+};
+
+#endif // NAMENORMALIZER_H
@@ -0,0 +1,128 @@
+#include "playlistparser.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QUrl>
+#include "songHandling/tagreader.h"
+
+/**
+  @class PlaylistParser
+  @ingroup songHandling
+  @brief Reads the song files listed in playlist and library manifest files.
+
+  Importing from a playlist only touches the files that the playlist lists, instead of scanning whole
+  folders. The supported formats are:
+  @n - M3U and M3U8 playlists. Lines that start with # are comments or extended info and are skipped.
+  @n - PLS playlists. Only the FileN= entries are used.
+  @n - Plain text manifests with one path per line, such as library exports. These are read like M3U.
+
+  Playlists are read one line at a time, so large manifests are never loaded into memory all at once.
+  Entries can be absolute paths, paths relative to the playlist's folder, or file:// URLs. Entries that
+  point at the same file are only returned once, and entries that aren't supported song files or that
+  don't exist are left out.
+*/
+
+//-----------------------------------------------
+// Static Variable Initialization
+//-----------------------------------------------
+
+const QStringList PlaylistParser::msSupportedPlaylistExtensions = QStringList() << "m3u" << "m3u8" << "pls" << "txt";
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Reads the song files listed in a playlist.
+ * @param aPlaylistPath The path of the playlist file.
+ * @return The absolute paths of the song files, in playlist order and without duplicates.
+ */
+QStringList PlaylistParser::parsePlaylist(const QString& aPlaylistPath)
+{
+    QStringList songPaths;
+    QFile playlistFile(aPlaylistPath);
+    if(!playlistFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        return songPaths;
+    }
+
+    // M3U8 and PLS files are UTF-8. Plain M3U files use the system encoding unless they have a byte order mark.
+    QString extension = QFileInfo(aPlaylistPath).suffix().toLower();
+    QTextStream stream(&playlistFile);
+    if(extension != "m3u")
+    {
+        stream.setCodec("UTF-8");
+    }
+
+    // Declare variables.
+    bool isPls = (extension == "pls");
+    QDir playlistDirectory = QFileInfo(aPlaylistPath).absoluteDir();
+    QSet<QString> seenPaths;
+    QString line, entry, songPath, seenKey;
+
+    while(stream.readLineInto(&line))
+    {
+        line = line.trimmed();
+        entry = isPls ? getEntryFromPlsLine(line) : (line.startsWith('#') ? QString() : line);
+        if(entry.isEmpty())
+        {
+            continue;
+        }
+
+        songPath = resolveEntry(entry, playlistDirectory);
+        if(!TagReader::isSupportedFile(songPath))
+        {
+            continue;
+        }
+
+        // Paths are case-insensitive on Windows, so compare them that way there.
+#ifdef Q_OS_WIN
+        seenKey = songPath.toLower();
+#else
+        seenKey = songPath;
+#endif
+        if(!seenPaths.contains(seenKey) && QFileInfo::exists(songPath))
+        {
+            seenPaths.insert(seenKey);
+            songPaths.append(songPath);
+        }
+    }
+
+    return songPaths;
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Gets the file entry from a line of a PLS playlist.
+ * @param aLine The line.
+ * @return The value of a FileN= line, or an empty string for any other line.
+ */
+QString PlaylistParser::getEntryFromPlsLine(const QString& aLine)
+{
+    if(!aLine.startsWith("File", Qt::CaseInsensitive))
+    {
+        return QString();
+    }
+    int equalsIndex = aLine.indexOf('=');
+    return (equalsIndex > 4) ? aLine.mid(equalsIndex + 1).trimmed() : QString();
+}
+
+/**
+ * @brief Turns a playlist entry into an absolute file path.
+ * @param aEntry The entry. It can be an absolute path, a path relative to the playlist, or a file:// URL.
+ * @param aPlaylistDirectory The folder that contains the playlist.
+ * @return The cleaned absolute path of the entry.
+ */
+QString PlaylistParser::resolveEntry(const QString& aEntry, const QDir& aPlaylistDirectory)
+{
+    QString path = aEntry;
+    if(path.startsWith("file:", Qt::CaseInsensitive))
+    {
+        path = QUrl(path).toLocalFile();
+    }
+    return QDir::cleanPath(aPlaylistDirectory.absoluteFilePath(path));
+}
@@ -0,0 +1,21 @@
+#ifndef PLAYLISTPARSER_H
+#define PLAYLISTPARSER_H
+
+#include <QDir>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class PlaylistParser
+{
+    public:
+        static QStringList parsePlaylist(const QString& aPlaylistPath);
+
+        static const QStringList msSupportedPlaylistExtensions; //!< The extensions of the playlist files that can be imported, without the dot.
+
+    private:
+        static QString getEntryFromPlsLine(const QString& aLine);
+        static QString resolveEntry(const QString& aEntry, const QDir& aPlaylistDirectory);
+};
+
+#endif // PLAYLISTPARSER_H
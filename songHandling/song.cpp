@@ -7,8 +7,19 @@
 
   This class is a container that represents a Song according to its metadata (artist, album, etc.) as well
   as its overall rank and file path.
+
+  Each song also has a 64-bit @link Song::getId id@endlink that is worked out from its file path. Importing the
+  same file again, even in a later session, gives it the same id, so the id can key anything that has to outlive
+  the Song object or its place in a list, without holding on to pointers, row numbers or path strings.
 */
 
+//-----------------------------------------------
+// Static Variable Initialization
+//-----------------------------------------------
+
+static const quint64 FNV_OFFSET_BASIS = 14695981039346656037ULL;
+static const quint64 FNV_PRIME = 1099511628211ULL;
+
 //-----------------------------------------------
 // Constructors and Destructor
 //-----------------------------------------------
@@ -22,6 +33,7 @@
  * @param aSongName The name of the song. Defaults to an empty string.
  */
 Song::Song(int aTrackNumber = 1, QString aAlbumName = "", QString aArtistName = "", QString aFilePath = "", QString aSongName = "") :
+    mId(getPathId(aFilePath)),
     mRank(UNRANKED),
     mTrackNumber(aTrackNumber),
     mAlbumName(aAlbumName),
@@ -67,6 +79,16 @@ QString Song::getFilePath() const
     return mFilePath;
 }
 
+/**
+ * @brief Gets the id of the song.
+ * @return The @link Song::getPathId id of the file path@endlink that the song was created with. It doesn't
+ * change if the file path is changed afterwards, so indices that are keyed by it stay valid.
+ */
+quint64 Song::getId() const
+{
+    return mId;
+}
+
 /**
  * @brief Gets the ranking of the song.
  * @return An integer representing the ranking of the song in the sorting.
@@ -152,6 +174,41 @@ void Song::setTrackNumber(int aTrackNumber)
     mTrackNumber = aTrackNumber;
 }
 
+/**
+ * @brief Gets the id of the song at a file path.
+ * @param aFilePath The path of the song file.
+ * @return A 64-bit hash of the cleaned up path. On Windows, where paths aren't case sensitive, the path is
+ * case folded first.
+ *
+ * This only looks at the path, so it can be used to check if a file has already been imported before reading it.
+ */
+quint64 Song::getPathId(const QString& aFilePath)
+{
+    QString path = QDir::cleanPath(QDir::fromNativeSeparators(aFilePath));
+#ifdef Q_OS_WIN
+    path = path.toCaseFolded();
+#endif
+    return hashBytes(path.toUtf8());
+}
+
+/**
+ * @brief Hashes bytes into a 64-bit value that is the same on every run.
+ * @param aBytes The bytes to hash.
+ * @return The 64-bit FNV-1a hash of the bytes.
+ *
+ * qHash can't be used for anything that is saved, since it's seeded differently each time the app runs.
+ */
+quint64 Song::hashBytes(const QByteArray& aBytes)
+{
+    quint64 hash = FNV_OFFSET_BASIS;
+    for(char byte : aBytes)
+    {
+        hash ^= (quint8)byte;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
 //-----------------------------------------------
 // Overloaded Operators
 //-----------------------------------------------
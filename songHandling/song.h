@@ -1,6 +1,8 @@
 #ifndef SONG_H
 #define SONG_H
 
+#include <QByteArray>
+#include <QDir>
 #include <QObject>
 #include <QString>
 
@@ -17,6 +19,7 @@ class Song : public QObject
         QString getAlbumName() const;
         QString getArtistName() const;
         QString getFilePath() const;
+        quint64 getId() const;
         int getRank() const;
         QString getSongName() const;
         int getTrackNumber() const;
@@ -27,12 +30,16 @@ class Song : public QObject
         void setSongName(QString aSongName);
         void setTrackNumber(int aTrackNumber);
 
+        static quint64 getPathId(const QString& aFilePath);
+        static quint64 hashBytes(const QByteArray& aBytes);
+
         bool operator <(const Song &aOtherSong) const;
         bool operator >(const Song &aOtherSong) const;
         bool operator <=(const Song &aOtherSong) const;
         bool operator >=(const Song &aOtherSong) const;
 
     private:
+        quint64 mId; //!< The id of the song, which is kept across sessions. See Song::getPathId.
         int mRank; //!< The ranking of the song in the sorting.
         int mTrackNumber; //!< The track number of the song in its album.
         QString mAlbumName; //!< The name of the album containing the song.
@@ -0,0 +1,221 @@
+#include "songbatch.h"
+
+#include <new>
+#include <QSet>
+
+/**
+  @class SongBatch
+  @ingroup songHandling
+  @brief Owns the @link Song songs@endlink from one or more imports.
+
+  Songs are created in blocks of @link SONG_BATCH_BLOCK_SIZE SONG_BATCH_BLOCK_SIZE@endlink instead of being
+  allocated one at a time, so that a whole batch can be thrown away at once:
+  @n - An import fills its own batch. If the import is cancelled, @link SongBatch::clear clear@endlink
+  frees every block of the batch together.
+  @n - If the import is accepted, the batch is @link SongBatch::merge merged@endlink into the library's batch.
+  This only moves the blocks over, so the songs keep their addresses and nothing is copied.
+  @n - Songs that are removed from a list are @link SongBatch::retainSongs released@endlink back into the batch,
+  and their slots are reused by the next songs that are created.
+
+  Songs that belong to a batch must never be deleted directly.
+
+  The batch also indexes its songs by @link Song::getId id@endlink, so that a song can be
+  @link SongBatch::getSong found@endlink in constant time without keeping a pointer to it.
+*/
+
+//-----------------------------------------------
+// Constructors and Destructor
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for a SongBatch.
+ */
+SongBatch::SongBatch()
+{}
+
+/**
+ * @brief Destructor for a SongBatch. All of the songs in the batch are destroyed.
+ */
+SongBatch::~SongBatch()
+{
+    clear();
+}
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Destroys all of the songs in the batch and frees its memory.
+ */
+void SongBatch::clear()
+{
+    for(Song* song : mSongs)
+    {
+        song->~Song();
+    }
+    for(Song* block : mBlocks)
+    {
+        ::operator delete(block);
+    }
+    mSongs.clear();
+    mSongsById.clear();
+    mBlocks.clear();
+    mFreeSlots.clear();
+    mNumUnusedSlots = 0;
+}
+
+/**
+ * @brief Creates a song in the batch.
+ * @param aTrackNumber The track number of the song.
+ * @param aAlbumName The name of the album which the song belongs to.
+ * @param aArtistName The name of the artist who made the song.
+ * @param aFilePath The file path to the song.
+ * @param aSongName The name of the song.
+ * @return The new song. The batch owns it.
+ */
+Song* SongBatch::createSong(int aTrackNumber, QString aAlbumName, QString aArtistName, QString aFilePath, QString aSongName)
+{
+    Song* newSong = new (allocateSlot()) Song(aTrackNumber, aAlbumName, aArtistName, aFilePath, aSongName);
+    mSongs.append(newSong);
+    if(!mSongsById.contains(newSong->getId()))
+    {
+        mSongsById.insert(newSong->getId(), newSong);
+    }
+    return newSong;
+}
+
+/**
+ * @brief Gets the number of songs in the batch.
+ * @return The number of songs in the batch.
+ */
+int SongBatch::getNumSongs() const
+{
+    return mSongs.count();
+}
+
+/**
+ * @brief Finds a song in the batch by its id.
+ * @param aSongId The @link Song::getId id@endlink of the song.
+ * @return The song, or null if no song in the batch has the id.
+ */
+Song* SongBatch::getSong(quint64 aSongId) const
+{
+    return mSongsById.value(aSongId, nullptr);
+}
+
+/**
+ * @brief Gets the songs in the batch.
+ * @return The songs in the batch, in the order they were created.
+ */
+QList<Song*> SongBatch::getSongs() const
+{
+    return mSongs;
+}
+
+/**
+ * @brief Moves all of the songs of another batch into this one.
+ * @param aOtherBatch The batch to take the songs from. It's left empty.
+ *
+ * Only the blocks change hands, so the songs keep their addresses.
+ */
+void SongBatch::merge(SongBatch* aOtherBatch)
+{
+    Q_ASSERT_X(aOtherBatch != this, "SongBatch::merge", "A batch can't be merged into itself!");
+
+    // The slots that the other batch never used are added to the free slots, since this batch keeps
+    // allocating from the end of its own newest block.
+    if(aOtherBatch->mNumUnusedSlots > 0)
+    {
+        Song* otherNewestBlock = aOtherBatch->mBlocks.last();
+        for(int slot = SONG_BATCH_BLOCK_SIZE - aOtherBatch->mNumUnusedSlots; slot < SONG_BATCH_BLOCK_SIZE; slot++)
+        {
+            mFreeSlots.append(otherNewestBlock + slot);
+        }
+    }
+
+    // Our newest block has to stay last, since that's the one the unused slots are in.
+    aOtherBatch->mBlocks += mBlocks;
+    mBlocks.swap(aOtherBatch->mBlocks);
+    mFreeSlots += aOtherBatch->mFreeSlots;
+    mSongs.append(aOtherBatch->mSongs);
+    for(QHash<quint64, Song*>::const_iterator iter = aOtherBatch->mSongsById.constBegin(); iter != aOtherBatch->mSongsById.constEnd(); ++iter)
+    {
+        if(!mSongsById.contains(iter.key()))
+        {
+            mSongsById.insert(iter.key(), iter.value());
+        }
+    }
+
+    aOtherBatch->mBlocks.clear();
+    aOtherBatch->mFreeSlots.clear();
+    aOtherBatch->mSongs.clear();
+    aOtherBatch->mSongsById.clear();
+    aOtherBatch->mNumUnusedSlots = 0;
+}
+
+/**
+ * @brief Releases every song in the batch that isn't in a list.
+ * @param aSongsToKeep The songs that are still being used. Every song in the list must belong to the batch.
+ *
+ * The released songs are destroyed, and their slots are reused by the next songs that are created.
+ */
+void SongBatch::retainSongs(const QList<Song*>& aSongsToKeep)
+{
+    QSet<Song*> songsToKeep = QSet<Song*>::fromList(aSongsToKeep);
+    QList<Song*> keptSongs;
+    for(Song* song : mSongs)
+    {
+        if(songsToKeep.contains(song))
+        {
+            keptSongs.append(song);
+        }
+        else
+        {
+            if(mSongsById.value(song->getId()) == song)
+            {
+                mSongsById.remove(song->getId());
+            }
+            song->~Song();
+            mFreeSlots.append(song);
+        }
+    }
+    mSongs = keptSongs;
+
+    // A released song may have hidden a kept song with the same id.
+    for(Song* song : mSongs)
+    {
+        if(!mSongsById.contains(song->getId()))
+        {
+            mSongsById.insert(song->getId(), song);
+        }
+    }
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Finds memory for a new song.
+ * @return A slot that a song can be constructed in. A released slot is used if there is one, otherwise
+ * the next unused slot of the newest block is used, and a new block is allocated if that one is full.
+ */
+Song* SongBatch::allocateSlot()
+{
+    if(!mFreeSlots.isEmpty())
+    {
+        Song* slot = mFreeSlots.last();
+        mFreeSlots.removeLast();
+        return slot;
+    }
+
+    if(mNumUnusedSlots == 0)
+    {
+        mBlocks.append(static_cast<Song*>(::operator new(SONG_BATCH_BLOCK_SIZE * sizeof(Song))));
+        mNumUnusedSlots = SONG_BATCH_BLOCK_SIZE;
+    }
+    Song* slot = mBlocks.last() + (SONG_BATCH_BLOCK_SIZE - mNumUnusedSlots);
+    mNumUnusedSlots--;
+    return slot;
+}
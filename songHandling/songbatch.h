@@ -0,0 +1,38 @@
+#ifndef SONGBATCH_H
+#define SONGBATCH_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include "songHandling/song.h"
+
+#define SONG_BATCH_BLOCK_SIZE 256
+
+class SongBatch
+{
+    public:
+        SongBatch();
+        ~SongBatch();
+
+        void clear();
+        Song* createSong(int aTrackNumber, QString aAlbumName, QString aArtistName, QString aFilePath, QString aSongName);
+        int getNumSongs() const;
+        Song* getSong(quint64 aSongId) const;
+        QList<Song*> getSongs() const;
+        void merge(SongBatch* aOtherBatch);
+        void retainSongs(const QList<Song*>& aSongsToKeep);
+
+    private:
+        Q_DISABLE_COPY(SongBatch)
+
+        Song* allocateSlot();
+
+        int mNumUnusedSlots = 0; //!< The number of slots at the end of the newest block that have never been used.
+        QVector<Song*> mBlocks; //!< The blocks of memory that songs are created in. Each one has room for SONG_BATCH_BLOCK_SIZE songs.
+        QVector<Song*> mFreeSlots; //!< Slots whose songs have been released and can be reused.
+        QList<Song*> mSongs; //!< The songs in the batch, in the order they were created.
+        QHash<quint64, Song*> mSongsById; //!< The songs in the batch, keyed by their \link Song::getId ids\endlink. If several songs share an id, only the first one is kept.
+};
+
+#endif // SONGBATCH_H
@@ -0,0 +1,167 @@
+#include "songlistsorter.h"
+
+#include <algorithm>
+#include <climits>
+#include <QCollatorSortKey>
+#include <QHash>
+
+/**
+  @class SongListSorter
+  @ingroup songHandling
+  @brief Sorts a list of songs by several fields at once.
+
+  Comparing strings with the locale's collation rules is slow, so it's only done once for each distinct
+  string when the songs are @link SongListSorter::setSongs set@endlink: every distinct string gets a
+  QCollatorSortKey, the strings are ordered by their keys, and each one is replaced by its position in that
+  order. After that, every field of a song is a plain integer, and a sort only compares small tuples of integers.
+
+  Sorts are stable, so songs that are equal in every sort key keep the order of the song list.
+*/
+
+//-----------------------------------------------
+// Constructors and Destructor
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for the SongListSorter.
+ *
+ * Strings are compared case-insensitively, and numbers in them are compared by value so that
+ * "Track 2" comes before "Track 10".
+ */
+SongListSorter::SongListSorter()
+{
+    mCollator.setCaseSensitivity(Qt::CaseInsensitive);
+    mCollator.setNumericMode(true);
+}
+
+/**
+ * @brief Destructor for the SongListSorter.
+ */
+SongListSorter::~SongListSorter()
+{}
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Sorts the songs.
+ * @param aSortKeys The fields to sort by. Later keys only break ties of earlier keys.
+ * @return The indices of the songs in the song list, in sorted order.
+ */
+QVector<int> SongListSorter::getSortedOrder(const QVector<sort_key>& aSortKeys) const
+{
+    QVector<int> order(mSongKeys.count());
+    for(int i = 0; i < order.count(); i++)
+    {
+        order[i] = i;
+    }
+
+    const song_keys* songKeys = mSongKeys.constData();
+    std::stable_sort(order.begin(), order.end(), [&](int aFirst, int aSecond)
+    {
+        for(const sort_key& sortKey : aSortKeys)
+        {
+            int firstKey = songKeys[aFirst].fields[sortKey.field];
+            int secondKey = songKeys[aSecond].fields[sortKey.field];
+            if(firstKey != secondKey)
+            {
+                return sortKey.ascending ? (firstKey < secondKey) : (firstKey > secondKey);
+            }
+        }
+        return false;
+    });
+    return order;
+}
+
+/**
+ * @brief Sets the songs to sort and computes their sort keys.
+ * @param aSongs The songs. The indices returned by @link SongListSorter::getSortedOrder getSortedOrder@endlink
+ * refer to this list.
+ */
+void SongListSorter::setSongs(const QList<Song*>& aSongs)
+{
+    // Gather the strings of each field so they can be collated together.
+    int numSongs = aSongs.count();
+    QStringList artistNames, albumNames, songNames;
+    artistNames.reserve(numSongs);
+    albumNames.reserve(numSongs);
+    songNames.reserve(numSongs);
+    for(const Song* song : aSongs)
+    {
+        artistNames.append(song->getArtistName());
+        albumNames.append(song->getAlbumName());
+        songNames.append(song->getSongName());
+    }
+    QVector<int> artistOrdinals = getCollationOrdinals(artistNames);
+    QVector<int> albumOrdinals = getCollationOrdinals(albumNames);
+    QVector<int> songNameOrdinals = getCollationOrdinals(songNames);
+
+    mSongKeys.resize(numSongs);
+    for(int i = 0; i < numSongs; i++)
+    {
+        // Unranked songs go after ranked ones.
+        int rank = aSongs[i]->getRank();
+        mSongKeys[i].fields[RANK] = (rank == UNRANKED) ? INT_MAX : rank;
+        mSongKeys[i].fields[ARTIST] = artistOrdinals[i];
+        mSongKeys[i].fields[ALBUM] = albumOrdinals[i];
+        mSongKeys[i].fields[TRACK_NUMBER] = aSongs[i]->getTrackNumber();
+        mSongKeys[i].fields[SONG_NAME] = songNameOrdinals[i];
+    }
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Replaces strings with their positions in collation order.
+ * @param aStrings The strings.
+ * @return The position of each string among the distinct strings, sorted with the collator. Strings that
+ * collate as equal get the same position.
+ */
+QVector<int> SongListSorter::getCollationOrdinals(const QStringList& aStrings) const
+{
+    // Find the distinct strings, so each one is only collated once.
+    QHash<QString, int> distinctIndices;
+    QVector<int> stringIndices(aStrings.count());
+    QVector<QCollatorSortKey> sortKeys;
+    for(int i = 0; i < aStrings.count(); i++)
+    {
+        QHash<QString, int>::const_iterator iter = distinctIndices.constFind(aStrings[i]);
+        if(iter == distinctIndices.constEnd())
+        {
+            iter = distinctIndices.insert(aStrings[i], sortKeys.count());
+            sortKeys.append(mCollator.sortKey(aStrings[i]));
+        }
+        stringIndices[i] = *iter;
+    }
+
+    // Sort the distinct strings by their keys and number them.
+    QVector<int> collatedOrder(sortKeys.count());
+    for(int i = 0; i < collatedOrder.count(); i++)
+    {
+        collatedOrder[i] = i;
+    }
+    std::sort(collatedOrder.begin(), collatedOrder.end(), [&](int aFirst, int aSecond)
+    {
+        return sortKeys[aFirst].compare(sortKeys[aSecond]) < 0;
+    });
+    QVector<int> distinctOrdinals(sortKeys.count());
+    int ordinal = 0;
+    for(int i = 0; i < collatedOrder.count(); i++)
+    {
+        if(i > 0 && sortKeys[collatedOrder[i - 1]].compare(sortKeys[collatedOrder[i]]) != 0)
+        {
+            ordinal++;
+        }
+        distinctOrdinals[collatedOrder[i]] = ordinal;
+    }
+
+    QVector<int> ordinals(aStrings.count());
+    for(int i = 0; i < aStrings.count(); i++)
+    {
+        ordinals[i] = distinctOrdinals[stringIndices[i]];
+    }
+    return ordinals;
+}
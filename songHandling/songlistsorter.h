@@ -0,0 +1,56 @@
+#ifndef SONGLISTSORTER_H
+#define SONGLISTSORTER_H
+
+#include <QCollator>
+#include <QList>
+#include <QStringList>
+#include <QVector>
+#include "songHandling/song.h"
+
+class SongListSorter
+{
+    public:
+        /**
+         * @brief The fields that songs can be sorted by.
+         */
+        typedef enum SORT_FIELD
+        {
+            RANK, //!< The rank of the song in the sorting.
+            ARTIST, //!< The name of the artist.
+            ALBUM, //!< The name of the album.
+            TRACK_NUMBER, //!< The track number.
+            SONG_NAME, //!< The name of the song.
+            NUM_SORT_FIELDS //!< The number of fields. This isn't a field.
+        } SORT_FIELD;
+
+        /**
+         * @brief One level of a multi-key sort.
+         */
+        typedef struct sort_key
+        {
+            SORT_FIELD field = RANK; //!< The field to compare.
+            bool ascending = true; //!< Whether smaller values come first.
+        } sort_key;
+
+        SongListSorter();
+        ~SongListSorter();
+
+        QVector<int> getSortedOrder(const QVector<sort_key>& aSortKeys) const;
+        void setSongs(const QList<Song*>& aSongs);
+
+    private:
+        /**
+         * @brief The precomputed sort keys of a song. Strings are replaced by their position in collation order.
+         */
+        typedef struct song_keys
+        {
+            int fields[NUM_SORT_FIELDS]; //!< The key of each \link SORT_FIELD field\endlink.
+        } song_keys;
+
+        QVector<int> getCollationOrdinals(const QStringList& aStrings) const;
+
+        QCollator mCollator; //!< Compares strings according to the user's locale.
+        QVector<song_keys> mSongKeys; //!< The keys of each song, in the order of the song list.
+};
+
+#endif // SONGLISTSORTER_H
@@ -0,0 +1,72 @@
+#include "tagreader.h"
+
+#include <string>
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+
+/**
+  @class TagReader
+  @ingroup songHandling
+  @brief Reads the tags of song files.
+
+  This is the tag-parsing step of importing, and every way of importing songs (folders, playlists, etc.)
+  goes through it once it has a list of file paths. It's only called through a
+  @link TagWorkerPool TagWorkerPool@endlink, which creates the @link Song songs@endlink, so that files that
+  hang or crash TagLib can't take the app down.
+*/
+
+//-----------------------------------------------
+// Static Variable Initialization
+//-----------------------------------------------
+
+const QStringList TagReader::msSupportedFileExtensions = QStringList() << "mp3" << "flac";
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Checks if a file has one of the @link TagReader::msSupportedFileExtensions supported extensions@endlink.
+ * @param aFilePath The path of the file.
+ * @return True if the file can be imported. The extension is compared case-insensitively.
+ */
+bool TagReader::isSupportedFile(const QString& aFilePath)
+{
+    return msSupportedFileExtensions.contains(QFileInfo(aFilePath).suffix().toLower());
+}
+
+/**
+ * @brief Reads the tags of a song file.
+ * @param aFilePath The path of the song file.
+ * @param aTags Set to the tags of the file.
+ * @return True if the file has readable tags.
+ */
+bool TagReader::readTags(const QString& aFilePath, song_tags* aTags)
+{
+    // Declare variables.
+    TagLib::FileRef file;
+    bool hasTags = false;
+
+    // Convert the QString containing the path so that we can use it with taglib. Taglib takes wide
+    // paths on Windows, and paths in the file system's 8-bit encoding everywhere else.
+#ifdef Q_OS_WIN
+    std::wstring filePathForTaglib = aFilePath.toStdWString();
+    file = TagLib::FileRef(TagLib::FileName(filePathForTaglib.c_str()));
+#else
+    QByteArray filePathForTaglib = QFile::encodeName(aFilePath);
+    file = TagLib::FileRef(TagLib::FileName(filePathForTaglib.constData()));
+#endif
+
+    // Use Taglib to get the metadata of the song.
+    if(!file.isNull() && file.tag() != nullptr)
+    {
+        aTags->artist_name = QString(file.tag()->artist().toCString(true));
+        aTags->album_name = QString(file.tag()->album().toCString(true));
+        aTags->song_name = QString(file.tag()->title().toCString(true));
+        aTags->track_number = (int)file.tag()->track();
+        hasTags = true;
+    }
+
+    return hasTags;
+}
@@ -0,0 +1,32 @@
+#ifndef TAGREADER_H
+#define TAGREADER_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <taglib/fileref.h>
+#include <taglib/tag.h>
+#include "songHandling/song.h"
+#include "songHandling/songbatch.h"
+
+class TagReader
+{
+    public:
+        /**
+         * @brief The tags of a song file.
+         */
+        typedef struct song_tags
+        {
+            int track_number = 1; //!< The track number of the song in its album.
+            QString album_name; //!< The name of the album containing the song.
+            QString artist_name; //!< The name of the artist who wrote the song.
+            QString song_name; //!< The name of the song.
+        } song_tags;
+
+        static bool isSupportedFile(const QString& aFilePath);
+        static bool readTags(const QString& aFilePath, song_tags* aTags);
+
+        static const QStringList msSupportedFileExtensions; //!< The extensions of the song files that can be imported, without the dot.
+};
+
+#endif // TAGREADER_H
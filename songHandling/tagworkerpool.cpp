@@ -0,0 +1,667 @@
+#include "tagworkerpool.h"
+
+#include <cstdio>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QtEndian>
+
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+/**
+  @class TagWorkerPool
+  @ingroup songHandling
+  @brief Reads the tags of song files in helper processes.
+
+  Malformed files can make TagLib hang or crash, so the tags are parsed by helper processes instead of by the
+  app itself. The helpers are the app's own executable started with @link TAG_WORKER_ARGUMENT TAG_WORKER_ARGUMENT@endlink,
+  which makes it run @link TagWorkerPool::runWorker runWorker@endlink instead of showing any windows.
+
+  The app and the helpers exchange length-prefixed messages over the helpers' standard input and output. Each
+  message is a big-endian 32-bit length followed by a QDataStream payload:
+  @n - Requests are a file index and a file path.
+  @n - Responses are the same file index, whether the file has tags, and the tags.
+
+  Each helper has up to @link TAG_WORKER_PIPELINE_DEPTH a few files@endlink in flight so that it never waits on the
+  app. Responses come back in order, so if a helper goes @link TAG_WORKER_TIMEOUT_MS too long@endlink without
+  answering, or if it exits, the oldest file that was sent to it is the suspect. The helper is restarted and every
+  file that was sent to it is queued again, but the suspect is only sent to a helper that has nothing else in
+  flight, so it gets the whole timeout to itself. A slow disk or a file that waited behind others gets a second
+  chance this way. If the suspect fails on its own as well, it's quarantined.
+
+  A helper can also fail for reasons that have nothing to do with its files, such as the executable not starting
+  properly. Files are only quarantined once some helper has answered, and after
+  @link MAX_TAG_WORKER_FAILURES a few@endlink failures in a row without any answer in between, the remaining
+  files are read in-process instead. Suspect files are left out of that import without being quarantined.
+
+  Files are queued in the order given by the @link IoScheduler IoScheduler@endlink, grouped by device. The next
+  file is taken from each device in turn, a device gets no more files while @link MAX_READS_PER_DEVICE a few@endlink
+  of its files are in flight, and the kernel is told to read ahead the tags of the @link READAHEAD_DEPTH next few@endlink
+  files on each device. The hints are given on worker threads, since each one opens a file.
+
+  Quarantined files are saved in the application's data directory and skipped by later imports until they change.
+  If the helpers can't be started at all, files are read in-process instead.
+*/
+
+//-----------------------------------------------
+// Constructors and Destructor
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for the TagWorkerPool.
+ * @param parent The parent of the pool.
+ *
+ * One helper is used per core. The helpers aren't started until files are read.
+ */
+TagWorkerPool::TagWorkerPool(QObject *parent) :
+    QObject(parent),
+    mQuarantinePath(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/quarantine.dat")
+{
+    mWorkers.resize(qMax(1, QThread::idealThreadCount()));
+    mAdviceThreadPool.setMaxThreadCount(MAX_READS_PER_DEVICE);
+    loadQuarantine();
+}
+
+/**
+ * @brief Destructor for the TagWorkerPool. The helpers are stopped.
+ */
+TagWorkerPool::~TagWorkerPool()
+{
+    for(int i = 0; i < mWorkers.count(); i++)
+    {
+        stopWorker(i);
+    }
+}
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Checks if a file has been quarantined.
+ * @param aFilePath The path of the file.
+ * @return True if the file hung or crashed a helper, and it hasn't changed since.
+ */
+bool TagWorkerPool::isQuarantined(const QString& aFilePath) const
+{
+    QHash<QString, QPair<qint64, qint64>>::const_iterator iter = mQuarantinedFiles.constFind(aFilePath);
+    if(iter == mQuarantinedFiles.constEnd())
+    {
+        return false;
+    }
+    QFileInfo fileInfo(aFilePath);
+    return iter->first == fileInfo.size() && iter->second == fileInfo.lastModified().toMSecsSinceEpoch();
+}
+
+/**
+ * @brief Reads the tags of song files.
+ * @param aFilePaths The paths of the song files.
+ * @param aBatch The batch that the new songs are created in.
+ * @param aLocations The @link IoScheduler::file_location location@endlink of each file, such as the ones that the
+ * @link DirectoryTraverser DirectoryTraverser@endlink found. If there isn't one for every file, they're looked up first.
+ * @return The new songs, in the same order as the paths. Files without readable tags, and files that are
+ * quarantined or that hang or crash a helper, are left out.
+ *
+ * Events are processed while the helpers work, so the UI keeps responding.
+ */
+QList<Song*> TagWorkerPool::readSongs(const QStringList& aFilePaths, SongBatch* aBatch, const QVector<IoScheduler::file_location>& aLocations)
+{
+    QList<Song*> songs;
+    if(mEventLoop != nullptr)
+    {
+        Q_ASSERT_X(false, "TagWorkerPool::readSongs", "Songs are already being read!");
+        return songs;
+    }
+
+    // Queue every file that isn't quarantined, in the order that keeps each device's reads sequential.
+    QVector<IoScheduler::file_location> locations = (aLocations.count() == aFilePaths.count()) ? aLocations : IoScheduler::getFileLocations(aFilePaths);
+    QVector<int> readOrder = IoScheduler::getReadOrder(locations);
+    mFilePaths = aFilePaths;
+    mTags = QVector<TagReader::song_tags>(aFilePaths.count());
+    mHasTags = QVector<bool>(aFilePaths.count(), false);
+    mAdvisedFiles = QVector<bool>(aFilePaths.count(), false);
+    mFileDevices = QVector<quint64>(aFilePaths.count());
+    mSuspectFiles = QVector<bool>(aFilePaths.count(), false);
+    mNumFinishedFiles = 0;
+    mNumQueuedFiles = 0;
+    for(int i = 0; i < readOrder.count(); i++)
+    {
+        int fileIndex = readOrder[i];
+        mFileDevices[fileIndex] = locations[fileIndex].device;
+        if(isQuarantined(aFilePaths[fileIndex]))
+        {
+            mNumFinishedFiles++;
+        }
+        else
+        {
+            queueFile(fileIndex, false);
+        }
+    }
+    adviseUpcomingFiles();
+
+    // Hand the files out to the helpers and wait for them to finish.
+    QEventLoop eventLoop;
+    mEventLoop = &eventLoop;
+    for(int i = 0; i < mWorkers.count() && mNumQueuedFiles > 0; i++)
+    {
+        if(mWorkers[i].process == nullptr && !mWorkersUnavailable)
+        {
+            startWorker(i);
+        }
+        dispatchFiles(i);
+    }
+    if(mWorkersUnavailable)
+    {
+        readQueuedFilesInProcess();
+    }
+    if(mNumFinishedFiles < mFilePaths.count())
+    {
+        eventLoop.exec();
+    }
+    mEventLoop = nullptr;
+
+    // Create the songs in the order of the paths.
+    for(int i = 0; i < mFilePaths.count(); i++)
+    {
+        if(mHasTags[i])
+        {
+            songs.append(aBatch->createSong(mTags[i].track_number, mTags[i].album_name, mTags[i].artist_name, mFilePaths[i], mTags[i].song_name));
+        }
+    }
+    mFilePaths.clear();
+    mTags.clear();
+    mHasTags.clear();
+    mAdvisedFiles.clear();
+    mFileDevices.clear();
+    mSuspectFiles.clear();
+    mDevices.clear();
+    mQueuedFiles.clear();
+    mReadsInFlight.clear();
+    mNextDevice = 0;
+    return songs;
+}
+
+/**
+ * @brief Runs a helper process.
+ * @return The exit code of the helper.
+ *
+ * The helper reads requests from its standard input and answers each one on its standard output, until its
+ * input is closed.
+ */
+int TagWorkerPool::runWorker()
+{
+#ifdef Q_OS_WIN
+    // Keep Windows from translating line endings in the binary messages.
+    int inputDescriptor = _fileno(stdin);
+    _setmode(inputDescriptor, _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#else
+    int inputDescriptor = fileno(stdin);
+#endif
+
+    // The input is read straight from its descriptor. A buffered read would wait to fill its buffer, but the app
+    // only sends a few short requests before it waits for the answers.
+    QFile input, output;
+    if(!input.open(inputDescriptor, QIODevice::ReadOnly | QIODevice::Unbuffered) || !output.open(stdout, QIODevice::WriteOnly))
+    {
+        return 1;
+    }
+
+    QByteArray request;
+    while(readMessage(&input, &request))
+    {
+        quint32 fileIndex = 0;
+        QString filePath;
+        QDataStream requestStream(request);
+        requestStream >> fileIndex >> filePath;
+
+        TagReader::song_tags tags;
+        bool hasTags = TagReader::readTags(filePath, &tags);
+
+        QByteArray response;
+        QDataStream responseStream(&response, QIODevice::WriteOnly);
+        responseStream << fileIndex << hasTags << (qint32)tags.track_number << tags.album_name << tags.artist_name << tags.song_name;
+        writeMessage(&output, response);
+        output.flush();
+    }
+    return 0;
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Tells the kernel to read ahead the tags of the next few queued files on each device.
+ */
+void TagWorkerPool::adviseUpcomingFiles()
+{
+    QStringList filesToAdvise;
+    for(int i = 0; i < mDevices.count(); i++)
+    {
+        const QList<int>& queuedFiles = mQueuedFiles[mDevices[i]];
+        for(int j = 0; j < queuedFiles.count() && j < READAHEAD_DEPTH; j++)
+        {
+            if(!mAdvisedFiles[queuedFiles[j]])
+            {
+                mAdvisedFiles[queuedFiles[j]] = true;
+                filesToAdvise.append(mFilePaths[queuedFiles[j]]);
+            }
+        }
+    }
+    IoScheduler::adviseTagRegionsInBackground(&mAdviceThreadPool, filesToAdvise);
+}
+
+/**
+ * @brief Sends queued files to a helper until it has a full pipeline, or until every device with queued files
+ * has as many reads in flight as it's allowed.
+ * @param aWorkerIndex The index of the helper.
+ */
+void TagWorkerPool::dispatchFiles(int aWorkerIndex)
+{
+    tag_worker& worker = mWorkers[aWorkerIndex];
+    if(worker.process == nullptr)
+    {
+        return;
+    }
+
+    // A suspect file is only sent to a helper that has nothing else in flight, and nothing is sent after it.
+    int fileIndex = 0;
+    while(worker.pending_files.count() < TAG_WORKER_PIPELINE_DEPTH
+          && (worker.pending_files.isEmpty() || !mSuspectFiles[worker.pending_files.last()])
+          && takeNextFile(&fileIndex, worker.pending_files.isEmpty()))
+    {
+        QByteArray request;
+        QDataStream requestStream(&request, QIODevice::WriteOnly);
+        requestStream << (quint32)fileIndex << mFilePaths[fileIndex];
+        writeMessage(worker.process, request);
+        worker.pending_files.append(fileIndex);
+    }
+
+    // The timeout covers the oldest pending file, so it only starts over when a response arrives.
+    if(worker.pending_files.isEmpty())
+    {
+        worker.timer->stop();
+    }
+    else if(!worker.timer->isActive())
+    {
+        worker.timer->start(TAG_WORKER_TIMEOUT_MS);
+    }
+    adviseUpcomingFiles();
+}
+
+/**
+ * @brief Sends queued files to every helper that has room for them.
+ *
+ * This is called whenever a read finishes, since a helper may have been left idle while the devices of the
+ * queued files were busy.
+ */
+void TagWorkerPool::dispatchFilesToAllWorkers()
+{
+    for(int i = 0; i < mWorkers.count() && mNumQueuedFiles > 0; i++)
+    {
+        dispatchFiles(i);
+    }
+}
+
+/**
+ * @brief Marks a file as done, and stops waiting once every file is done.
+ * @param aFileIndex The index of the file.
+ */
+void TagWorkerPool::finishFile(int aFileIndex)
+{
+    Q_UNUSED(aFileIndex);
+    mNumFinishedFiles++;
+    if(mNumFinishedFiles == mFilePaths.count() && mEventLoop != nullptr)
+    {
+        mEventLoop->quit();
+    }
+}
+
+/**
+ * @brief Handles a helper that timed out, exited or sent something unreadable.
+ * @param aWorkerIndex The index of the helper.
+ *
+ * The oldest file that was sent to the helper becomes a suspect, and every file that was sent to it is queued
+ * again. A suspect that was sent on its own is quarantined instead, as long as the helpers have shown that they
+ * work. The helper is restarted, unless the helpers have failed too many times in a row, in which case the
+ * remaining files are read in-process.
+ */
+void TagWorkerPool::handleWorkerFailure(int aWorkerIndex)
+{
+    QList<int> pendingFiles = mWorkers[aWorkerIndex].pending_files;
+    stopWorker(aWorkerIndex);
+    mNumFailuresWithoutAnswer++;
+
+    for(int fileIndex : pendingFiles)
+    {
+        mReadsInFlight[mFileDevices[fileIndex]]--;
+    }
+    if(!pendingFiles.isEmpty())
+    {
+        int culprit = pendingFiles.takeFirst();
+        for(int i = pendingFiles.count() - 1; i >= 0; i--)
+        {
+            queueFile(pendingFiles[i], true);
+        }
+        if(mSuspectFiles[culprit] && mWorkersHaveAnswered)
+        {
+            quarantineFile(mFilePaths[culprit]);
+            finishFile(culprit);
+        }
+        else
+        {
+            mSuspectFiles[culprit] = true;
+            queueFile(culprit, true);
+        }
+    }
+
+    if(mEventLoop != nullptr && mNumQueuedFiles > 0)
+    {
+        if(mNumFailuresWithoutAnswer < MAX_TAG_WORKER_FAILURES && startWorker(aWorkerIndex))
+        {
+            dispatchFilesToAllWorkers();
+        }
+        else
+        {
+            readQueuedFilesInProcess();
+        }
+    }
+}
+
+/**
+ * @brief Parses the responses that a helper has written so far.
+ * @param aWorkerIndex The index of the helper.
+ */
+void TagWorkerPool::handleWorkerOutput(int aWorkerIndex)
+{
+    tag_worker& worker = mWorkers[aWorkerIndex];
+    worker.output.append(worker.process->readAllStandardOutput());
+
+    while(worker.output.size() >= (int)sizeof(quint32))
+    {
+        quint32 messageSize = qFromBigEndian<quint32>((const uchar*)worker.output.constData());
+        if(messageSize > MAX_TAG_WORKER_MESSAGE_SIZE || worker.pending_files.isEmpty())
+        {
+            handleWorkerFailure(aWorkerIndex);
+            return;
+        }
+        if(worker.output.size() < (int)(sizeof(quint32) + messageSize))
+        {
+            break;
+        }
+
+        // Declare variables.
+        quint32 fileIndex = 0;
+        bool hasTags = false;
+        qint32 trackNumber = 1;
+        TagReader::song_tags tags;
+
+        QDataStream responseStream(worker.output.mid(sizeof(quint32), messageSize));
+        responseStream >> fileIndex >> hasTags >> trackNumber >> tags.album_name >> tags.artist_name >> tags.song_name;
+        worker.output.remove(0, sizeof(quint32) + messageSize);
+        if(responseStream.status() != QDataStream::Ok || (int)fileIndex != worker.pending_files.first())
+        {
+            handleWorkerFailure(aWorkerIndex);
+            return;
+        }
+
+        tags.track_number = trackNumber;
+        mNumFailuresWithoutAnswer = 0;
+        mWorkersHaveAnswered = true;
+        mTags[fileIndex] = tags;
+        mHasTags[fileIndex] = hasTags;
+        worker.pending_files.removeFirst();
+        worker.timer->stop();
+        mReadsInFlight[mFileDevices[fileIndex]]--;
+        finishFile(fileIndex);
+    }
+    dispatchFilesToAllWorkers();
+}
+
+/**
+ * @brief Loads the quarantined files that were saved by previous sessions.
+ */
+void TagWorkerPool::loadQuarantine()
+{
+    QFile quarantineFile(mQuarantinePath);
+    if(quarantineFile.open(QIODevice::ReadOnly))
+    {
+        QDataStream stream(&quarantineFile);
+        stream >> mQuarantinedFiles;
+        if(stream.status() != QDataStream::Ok)
+        {
+            mQuarantinedFiles.clear();
+        }
+    }
+}
+
+/**
+ * @brief Quarantines a file so that it's skipped until it changes.
+ * @param aFilePath The path of the file.
+ */
+void TagWorkerPool::quarantineFile(const QString& aFilePath)
+{
+    QFileInfo fileInfo(aFilePath);
+    mQuarantinedFiles.insert(aFilePath, qMakePair(fileInfo.size(), fileInfo.lastModified().toMSecsSinceEpoch()));
+    saveQuarantine();
+}
+
+/**
+ * @brief Adds a file to the queue of its device.
+ * @param aFileIndex The index of the file.
+ * @param aAtFront True to put the file before the device's other queued files, for files that were already
+ * sent to a helper. Otherwise, it goes after them.
+ */
+void TagWorkerPool::queueFile(int aFileIndex, bool aAtFront)
+{
+    quint64 device = mFileDevices[aFileIndex];
+    if(!mQueuedFiles.contains(device))
+    {
+        mDevices.append(device);
+    }
+    QList<int>& queuedFiles = mQueuedFiles[device];
+    if(aAtFront)
+    {
+        queuedFiles.prepend(aFileIndex);
+    }
+    else
+    {
+        queuedFiles.append(aFileIndex);
+    }
+    mNumQueuedFiles++;
+}
+
+/**
+ * @brief Reads every queued file in this process. This is only used if the helpers can't be started or keep failing.
+ *
+ * Suspect files are left out, since they may be what made the helpers fail. They aren't quarantined, so
+ * they're tried again by the next import.
+ */
+void TagWorkerPool::readQueuedFilesInProcess()
+{
+    mWorkersUnavailable = true;
+    int fileIndex = 0;
+    while(takeNextFile(&fileIndex, true))
+    {
+        mReadsInFlight[mFileDevices[fileIndex]]--;
+        if(!mSuspectFiles[fileIndex])
+        {
+            adviseUpcomingFiles();
+            mHasTags[fileIndex] = TagReader::readTags(mFilePaths[fileIndex], &mTags[fileIndex]);
+        }
+        finishFile(fileIndex);
+    }
+}
+
+/**
+ * @brief Saves the quarantined files. The file is replaced atomically.
+ */
+void TagWorkerPool::saveQuarantine()
+{
+    QDir().mkpath(QFileInfo(mQuarantinePath).absolutePath());
+    QSaveFile quarantineFile(mQuarantinePath);
+    if(quarantineFile.open(QIODevice::WriteOnly))
+    {
+        QDataStream stream(&quarantineFile);
+        stream << mQuarantinedFiles;
+        quarantineFile.commit();
+    }
+}
+
+/**
+ * @brief Starts a helper.
+ * @param aWorkerIndex The index of the helper.
+ * @return True if the helper started.
+ */
+bool TagWorkerPool::startWorker(int aWorkerIndex)
+{
+    tag_worker& worker = mWorkers[aWorkerIndex];
+    worker.process = new QProcess(this);
+    worker.timer = new QTimer(this);
+    worker.timer->setSingleShot(true);
+    worker.output.clear();
+    worker.pending_files.clear();
+
+    // The helpers' errors aren't used, so don't let them fill a pipe.
+    worker.process->setProcessChannelMode(QProcess::SeparateChannels);
+    worker.process->setStandardErrorFile(QProcess::nullDevice());
+    worker.process->start(QCoreApplication::applicationFilePath(), QStringList() << TAG_WORKER_ARGUMENT);
+    if(!worker.process->waitForStarted())
+    {
+        stopWorker(aWorkerIndex);
+        mWorkersUnavailable = true;
+        return false;
+    }
+
+    connect(worker.process, &QProcess::readyReadStandardOutput, this, [=](){ handleWorkerOutput(aWorkerIndex); });
+    connect(worker.process, qOverload<int, QProcess::ExitStatus>(&QProcess::finished), this, [=](int, QProcess::ExitStatus){ handleWorkerFailure(aWorkerIndex); });
+    connect(worker.timer, &QTimer::timeout, this, [=](){ handleWorkerFailure(aWorkerIndex); });
+    return true;
+}
+
+/**
+ * @brief Stops a helper. The files that were sent to it are forgotten.
+ * @param aWorkerIndex The index of the helper.
+ */
+void TagWorkerPool::stopWorker(int aWorkerIndex)
+{
+    tag_worker& worker = mWorkers[aWorkerIndex];
+    if(worker.process != nullptr)
+    {
+        // Disconnect first so that the helper exiting isn't treated as a failure.
+        worker.process->disconnect(this);
+        worker.process->closeWriteChannel();
+        if(!worker.process->waitForFinished(100))
+        {
+            worker.process->kill();
+            worker.process->waitForFinished(1000);
+        }
+        worker.process->deleteLater();
+        worker.process = nullptr;
+    }
+    if(worker.timer != nullptr)
+    {
+        worker.timer->disconnect(this);
+        worker.timer->deleteLater();
+        worker.timer = nullptr;
+    }
+    worker.output.clear();
+    worker.pending_files.clear();
+}
+
+/**
+ * @brief Takes the next queued file from a device that has room for another read.
+ * @param aFileIndex Set to the index of the file.
+ * @param aAllowSuspects True if the next file of a device can be a suspect file. Otherwise, devices whose next
+ * file is a suspect are skipped.
+ * @return False if no file is queued, or if every device with queued files already has as many reads in flight
+ * as it's allowed.
+ *
+ * The devices take turns, so that a large folder on one device doesn't hold up the files on the others.
+ */
+bool TagWorkerPool::takeNextFile(int* aFileIndex, bool aAllowSuspects)
+{
+    for(int i = 0; i < mDevices.count(); i++)
+    {
+        int deviceIndex = (mNextDevice + i) % mDevices.count();
+        quint64 device = mDevices[deviceIndex];
+        QList<int>& queuedFiles = mQueuedFiles[device];
+        if(!queuedFiles.isEmpty() && mReadsInFlight.value(device) < MAX_READS_PER_DEVICE
+           && (aAllowSuspects || !mSuspectFiles[queuedFiles.first()]))
+        {
+            *aFileIndex = queuedFiles.takeFirst();
+            mReadsInFlight[device]++;
+            mNumQueuedFiles--;
+            mNextDevice = (deviceIndex + 1) % mDevices.count();
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Reads a length-prefixed message.
+ * @param aDevice The device to read from. Reads block until the whole message has arrived.
+ * @param aMessage Set to the message.
+ * @return False if the device was closed or the message is too large.
+ */
+bool TagWorkerPool::readMessage(QIODevice* aDevice, QByteArray* aMessage)
+{
+    uchar sizeBytes[sizeof(quint32)];
+    if(!readFully(aDevice, (char*)sizeBytes, sizeof(quint32)))
+    {
+        return false;
+    }
+    quint32 messageSize = qFromBigEndian<quint32>(sizeBytes);
+    if(messageSize > MAX_TAG_WORKER_MESSAGE_SIZE)
+    {
+        return false;
+    }
+    aMessage->resize(messageSize);
+    return readFully(aDevice, aMessage->data(), messageSize);
+}
+
+/**
+ * @brief Reads an exact number of bytes, waiting for more to arrive when a read comes back short.
+ * @param aDevice The device to read from.
+ * @param aData The buffer that the bytes are read into.
+ * @param aSize The number of bytes to read.
+ * @return False if the device was closed or failed before every byte was read.
+ */
+bool TagWorkerPool::readFully(QIODevice* aDevice, char* aData, qint64 aSize)
+{
+    qint64 numRead = 0;
+    while(numRead < aSize)
+    {
+        qint64 result = aDevice->read(aData + numRead, aSize - numRead);
+        if(result < 0 || (result == 0 && !aDevice->waitForReadyRead(-1)))
+        {
+            return false;
+        }
+        numRead += result;
+    }
+    return true;
+}
+
+/**
+ * @brief Writes a length-prefixed message.
+ * @param aDevice The device to write to.
+ * @param aMessage The message.
+ */
+void TagWorkerPool::writeMessage(QIODevice* aDevice, const QByteArray& aMessage)
+{
+    uchar sizeBytes[sizeof(quint32)];
+    qToBigEndian<quint32>(aMessage.size(), sizeBytes);
+    aDevice->write((const char*)sizeBytes, sizeof(quint32));
+    aDevice->write(aMessage);
+}
@@ -0,0 +1,95 @@
+#ifndef TAGWORKERPOOL_H
+#define TAGWORKERPOOL_H
+
+#include <QByteArray>
+#include <QEventLoop>
+#include <QHash>
+#include <QIODevice>
+#include <QList>
+#include <QObject>
+#include <QPair>
+#include <QProcess>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+#include "songHandling/ioscheduler.h"
+#include "songHandling/song.h"
+#include "songHandling/songbatch.h"
+#include "songHandling/tagreader.h"
+
+#define TAG_WORKER_ARGUMENT "--tag-worker"
+#define TAG_WORKER_TIMEOUT_MS 5000
+#define TAG_WORKER_PIPELINE_DEPTH 4
+#define MAX_TAG_WORKER_FAILURES 3
+#define MAX_TAG_WORKER_MESSAGE_SIZE (1024 * 1024)
+
+class TagWorkerPool : public QObject
+{
+    Q_OBJECT
+
+    public:
+        explicit TagWorkerPool(QObject *parent = 0);
+        ~TagWorkerPool();
+
+        bool isQuarantined(const QString& aFilePath) const;
+        QList<Song*> readSongs(const QStringList& aFilePaths, SongBatch* aBatch,
+                               const QVector<IoScheduler::file_location>& aLocations = QVector<IoScheduler::file_location>());
+
+        static int runWorker();
+
+    private:
+        /**
+         * @brief A helper process that parses tags, and the files that have been sent to it.
+         */
+        typedef struct tag_worker
+        {
+            QProcess* process = nullptr; //!< The helper process. Null if it isn't running.
+            QTimer* timer = nullptr; //!< Fires if the oldest pending file takes too long.
+            QByteArray output; //!< Output from the process that hasn't been parsed yet.
+            QList<int> pending_files; //!< The indices of the files that have been sent to the process, oldest first.
+        } tag_worker;
+
+        void adviseUpcomingFiles();
+        void dispatchFiles(int aWorkerIndex);
+        void dispatchFilesToAllWorkers();
+        void finishFile(int aFileIndex);
+        void handleWorkerFailure(int aWorkerIndex);
+        void handleWorkerOutput(int aWorkerIndex);
+        void loadQuarantine();
+        void quarantineFile(const QString& aFilePath);
+        void queueFile(int aFileIndex, bool aAtFront);
+        void readQueuedFilesInProcess();
+        void saveQuarantine();
+        bool startWorker(int aWorkerIndex);
+        void stopWorker(int aWorkerIndex);
+        bool takeNextFile(int* aFileIndex, bool aAllowSuspects);
+
+        static bool readFully(QIODevice* aDevice, char* aData, qint64 aSize);
+        static bool readMessage(QIODevice* aDevice, QByteArray* aMessage);
+        static void writeMessage(QIODevice* aDevice, const QByteArray& aMessage);
+
+        QVector<bool> mAdvisedFiles; //!< Whether or not the kernel has been told to read ahead the tags of each file.
+        QThreadPool mAdviceThreadPool; //!< The worker threads that tell the kernel to read ahead, so that opening files doesn't block the GUI thread.
+        QList<quint64> mDevices; //!< The devices that the files are on.
+        QEventLoop* mEventLoop = nullptr; //!< Runs while files are being read. Null when the pool is idle.
+        QVector<quint64> mFileDevices; //!< The device that each file is on.
+        QStringList mFilePaths; //!< The files that are being read.
+        QVector<bool> mHasTags; //!< Whether or not each file has been read and had readable tags.
+        int mNextDevice = 0; //!< The index of the device that the next file is taken from, so that every device is kept busy.
+        int mNumFinishedFiles = 0; //!< The number of files that have been read, failed or been skipped.
+        int mNumFailuresWithoutAnswer = 0; //!< The number of times in a row that a helper has failed without any helper answering in between.
+        int mNumQueuedFiles = 0; //!< The number of files that haven't been sent to a worker yet.
+        QHash<QString, QPair<qint64, qint64>> mQuarantinedFiles; //!< The size and modification time of each file that hung or crashed a worker.
+        QString mQuarantinePath; //!< The path of the file that the quarantined files are saved to.
+        QHash<quint64, QList<int>> mQueuedFiles; //!< The indices of the files on each device that haven't been sent to a worker yet, in read order.
+        QHash<quint64, int> mReadsInFlight; //!< The number of files on each device that have been sent to a worker and not answered yet.
+        QVector<bool> mSuspectFiles; //!< Whether or not each file was pending when a helper failed. Suspect files are sent to a helper on their own.
+        QVector<TagReader::song_tags> mTags; //!< The tags of each file.
+        QVector<tag_worker> mWorkers; //!< The helper processes.
+        bool mWorkersHaveAnswered = false; //!< Set once any helper has answered, which shows that the helpers themselves work.
+        bool mWorkersUnavailable = false; //!< Set if a helper process couldn't be started or kept failing, in which case files are read in-process.
+};
+
+#endif // TAGWORKERPOOL_H
@@ -0,0 +1,559 @@
+#include "tagwriter.h"
+
+#include <algorithm>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <taglib/flacfile.h>
+#include <taglib/id3v2framefactory.h>
+#include <taglib/id3v2tag.h>
+#include <taglib/mpegfile.h>
+#include <taglib/popularimeterframe.h>
+#include <taglib/textidentificationframe.h>
+#include <taglib/tbytevectorstream.h>
+#include <taglib/xiphcomment.h>
+
+/**
+  @class TagWriter
+  @ingroup songHandling
+  @brief Writes the ranks from a finished sort into the tags of the song files.
+
+  Each file gets its rank in a @link RANK_TAG_NAME custom tag@endlink, and a rating that other players can
+  read, scaled from the favorite (the highest rating) to the least favorite (the lowest rating):
+  @n - MP3 files get a TXXX frame for the rank and a POPM frame for the rating, under the
+  @link POPULARIMETER_EMAIL app's own email@endlink so that ratings from other players are left alone.
+  @n - FLAC files get Vorbis comments for the rank and for an @link RATING_TAG_NAME FMPS rating@endlink.
+
+  Files are written in @link TAG_WRITE_BATCH_SIZE batches@endlink on a @link MAX_TAG_WRITE_THREADS few@endlink
+  worker threads. No file is ever left half-written: each file is read into memory, its tags are changed there,
+  the result is parsed again to check that it holds the new rank, and only then is it written to a temporary
+  file that atomically replaces the original. A file that changed while it was being written is left alone.
+
+  The writes that haven't finished are kept in a journal in the application's data directory, which is saved
+  every @link TAG_WRITE_JOURNAL_INTERVAL few files@endlink. If the app is closed partway through, the
+  remaining files are written when it's next started. Files that already hold the right rank are skipped, so
+  files that were written just before an interruption aren't written again.
+*/
+
+//-----------------------------------------------
+// Static Variable Initialization
+//-----------------------------------------------
+
+static const quint32 TAG_WRITE_JOURNAL_MAGIC = 0x53535457; // "SSTW"
+
+//-----------------------------------------------
+// Constructors and Destructor
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for the TagWriter.
+ * @param parent The parent of the writer.
+ *
+ * The writes that were left unfinished by a previous session are loaded, but aren't started until
+ * @link TagWriter::resumePendingWrites resumePendingWrites@endlink is called.
+ */
+TagWriter::TagWriter(QObject *parent) :
+    QObject(parent),
+    mJournalPath(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/tagwrites.dat"),
+    mStopping(false)
+{
+    mThreadPool.setMaxThreadCount(qMin(QThread::idealThreadCount(), MAX_TAG_WRITE_THREADS));
+    loadJournal();
+}
+
+/**
+ * @brief Destructor for the TagWriter.
+ *
+ * Jobs that haven't started are dropped, and running jobs stop after the file that they're writing. The
+ * journal is saved so that the rest of the files are written in the next session.
+ */
+TagWriter::~TagWriter()
+{
+    mStopping = true;
+    mThreadPool.clear();
+    mThreadPool.waitForDone();
+    saveJournal();
+}
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Gets the number of files that haven't been written yet.
+ * @return The number of pending writes, including the ones left over from a previous session.
+ */
+int TagWriter::getNumPendingWrites() const
+{
+    return mPendingWrites.count();
+}
+
+/**
+ * @brief Gets the rating that a rank is written as.
+ * @param aWrite The rank.
+ * @return A rating from 0 for the least favorite song to 1 for the favorite.
+ */
+double TagWriter::getRating(const rank_write& aWrite)
+{
+    if(aWrite.num_ranked <= 1)
+    {
+        return 1.0;
+    }
+    return qBound(0.0, 1.0 - (double)(aWrite.rank - 1) / (aWrite.num_ranked - 1), 1.0);
+}
+
+/**
+ * @brief Checks if files are being written.
+ * @return True if files are being written.
+ */
+bool TagWriter::isWriting() const
+{
+    return mNumFinished < mNumFiles;
+}
+
+/**
+ * @brief Starts writing the files that were left unfinished by a previous session.
+ * @return True if there were files to write.
+ */
+bool TagWriter::resumePendingWrites()
+{
+    if(isWriting() || mPendingWrites.isEmpty())
+    {
+        return false;
+    }
+    startWriting();
+    return true;
+}
+
+/**
+ * @brief Starts writing the ranks of songs into their files.
+ * @param aSongs The songs. Songs that aren't ranked are skipped.
+ * @return True if writing started. False if files are already being written or none of the songs are ranked.
+ *
+ * @link TagWriter::progressChanged progressChanged@endlink is emitted as the files are written, and
+ * @link TagWriter::writingFinished writingFinished@endlink once they're all done.
+ */
+bool TagWriter::writeRanks(const QList<Song*>& aSongs)
+{
+    if(isWriting())
+    {
+        Q_ASSERT_X(false, "TagWriter::writeRanks", "Ranks are already being written!");
+        return false;
+    }
+
+    // The rating is scaled by the number of ranked songs, so count them first.
+    int numRanked = 0;
+    for(const Song* song : aSongs)
+    {
+        if(song->getRank() != UNRANKED)
+        {
+            numRanked++;
+        }
+    }
+    for(const Song* song : aSongs)
+    {
+        if(song->getRank() != UNRANKED)
+        {
+            rank_write write;
+            write.file_path = song->getFilePath();
+            write.rank = song->getRank();
+            write.num_ranked = numRanked;
+            mPendingWrites.insert(song->getId(), write);
+        }
+    }
+    if(mPendingWrites.isEmpty())
+    {
+        return false;
+    }
+
+    // Save the journal before touching any files, so that an interruption can be resumed.
+    saveJournal();
+    startWriting();
+    return true;
+}
+
+/**
+ * @brief Writes a rank into the tags of a file.
+ * @param aWrite The file and its rank.
+ * @return True if the file holds the rank, whether it was written or already held it.
+ *
+ * The original file is only ever replaced as a whole, and only by a version that has been checked to hold the rank.
+ */
+bool TagWriter::writeRank(const rank_write& aWrite)
+{
+    QString extension = QFileInfo(aWrite.file_path).suffix().toLower();
+    QFileInfo originalInfo(aWrite.file_path);
+    qint64 originalSize = originalInfo.size();
+    QDateTime originalModified = originalInfo.lastModified();
+
+    QFile originalFile(aWrite.file_path);
+    if(!originalFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    QByteArray contents = originalFile.readAll();
+    originalFile.close();
+    if(contents.size() != originalSize)
+    {
+        return false;
+    }
+
+    bool changed = false;
+    if(!applyRank(&contents, extension, aWrite, &changed))
+    {
+        return false;
+    }
+    if(!changed)
+    {
+        return true;
+    }
+
+    // Make sure that the new version parses and holds the rank before it replaces anything.
+    if(readRank(contents, extension) != aWrite.rank)
+    {
+        return false;
+    }
+
+    // Don't overwrite changes that another program made while we were working.
+    QFileInfo currentInfo(aWrite.file_path);
+    if(currentInfo.size() != originalSize || currentInfo.lastModified() != originalModified)
+    {
+        return false;
+    }
+
+    QSaveFile savedFile(aWrite.file_path);
+    if(!savedFile.open(QIODevice::WriteOnly) || savedFile.write(contents) != contents.size())
+    {
+        savedFile.cancelWriting();
+        return false;
+    }
+    return savedFile.commit();
+}
+
+//-----------------------------------------------
+// Slots
+//-----------------------------------------------
+
+/**
+ * @brief Handles a job finishing a batch of files.
+ * @param aWrittenFiles The files that hold their rank now.
+ * @param aFailedFiles The files that couldn't be written. They aren't retried.
+ */
+void TagWriter::on_batchWritten(QStringList aWrittenFiles, QStringList aFailedFiles)
+{
+    for(const QString& filePath : aWrittenFiles + aFailedFiles)
+    {
+        mPendingWrites.remove(Song::getPathId(filePath));
+    }
+    mNumFailed += aFailedFiles.count();
+    mNumFinished += aWrittenFiles.count() + aFailedFiles.count();
+    mNumUnsavedWrites += aWrittenFiles.count() + aFailedFiles.count();
+
+    if(mNumUnsavedWrites >= TAG_WRITE_JOURNAL_INTERVAL || !isWriting())
+    {
+        saveJournal();
+    }
+    emit progressChanged(mNumFinished, mNumFiles);
+    if(!isWriting())
+    {
+        emit writingFinished(mNumFailed);
+    }
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Sets the rank and rating in the tags of a file that has been read into memory.
+ * @param aContents The contents of the file. Changed in place.
+ * @param aExtension The extension of the file, in lower case.
+ * @param aWrite The rank to write.
+ * @param aChanged Set to true if the tags didn't already hold the rank and rating.
+ * @return False if the file couldn't be parsed or saved.
+ */
+bool TagWriter::applyRank(QByteArray* aContents, const QString& aExtension, const rank_write& aWrite, bool* aChanged)
+{
+    TagLib::ByteVector data(aContents->constData(), aContents->size());
+    TagLib::ByteVectorStream stream(data);
+    TagLib::String rankText = TagLib::String::number(aWrite.rank);
+    double rating = getRating(aWrite);
+    *aChanged = false;
+
+    if(aExtension == "mp3")
+    {
+        TagLib::MPEG::File file(&stream, TagLib::ID3v2::FrameFactory::instance(), false);
+        if(!file.isValid())
+        {
+            return false;
+        }
+        TagLib::ID3v2::Tag* tag = file.ID3v2Tag(true);
+
+        // The rank goes in a TXXX frame of its own.
+        TagLib::ID3v2::UserTextIdentificationFrame* rankFrame = TagLib::ID3v2::UserTextIdentificationFrame::find(tag, RANK_TAG_NAME);
+        if(rankFrame == nullptr)
+        {
+            rankFrame = new TagLib::ID3v2::UserTextIdentificationFrame(TagLib::String::UTF8);
+            rankFrame->setDescription(RANK_TAG_NAME);
+            tag->addFrame(rankFrame);
+            *aChanged = true;
+        }
+        if(rankFrame->fieldList().size() < 2 || rankFrame->fieldList()[1] != rankText)
+        {
+            rankFrame->setText(rankText);
+            *aChanged = true;
+        }
+
+        // POPM ratings go from 1 to 255. 0 means that the song isn't rated.
+        int popularimeterRating = 1 + qRound(rating * 254);
+        TagLib::ID3v2::PopularimeterFrame* ratingFrame = nullptr;
+        TagLib::ID3v2::FrameList ratingFrames = tag->frameList("POPM");
+        for(TagLib::ID3v2::FrameList::ConstIterator iter = ratingFrames.begin(); iter != ratingFrames.end(); ++iter)
+        {
+            TagLib::ID3v2::PopularimeterFrame* frame = dynamic_cast<TagLib::ID3v2::PopularimeterFrame*>(*iter);
+            if(frame != nullptr && frame->email() == POPULARIMETER_EMAIL)
+            {
+                ratingFrame = frame;
+                break;
+            }
+        }
+        if(ratingFrame == nullptr)
+        {
+            ratingFrame = new TagLib::ID3v2::PopularimeterFrame();
+            ratingFrame->setEmail(POPULARIMETER_EMAIL);
+            tag->addFrame(ratingFrame);
+            *aChanged = true;
+        }
+        if(ratingFrame->rating() != popularimeterRating)
+        {
+            ratingFrame->setRating(popularimeterRating);
+            *aChanged = true;
+        }
+
+        // Only the ID3v2 tag is saved. Any other tags in the file are left as they are.
+        if(*aChanged && !file.save(TagLib::MPEG::File::ID3v2, false))
+        {
+            return false;
+        }
+    }
+    else if(aExtension == "flac")
+    {
+        TagLib::FLAC::File file(&stream, TagLib::ID3v2::FrameFactory::instance(), false);
+        if(!file.isValid())
+        {
+            return false;
+        }
+        TagLib::Ogg::XiphComment* comment = file.xiphComment(true);
+        TagLib::String ratingText(QString::number(rating, 'f', 6).toUtf8().constData(), TagLib::String::UTF8);
+        const TagLib::Ogg::FieldListMap& fields = comment->fieldListMap();
+        if(!fields.contains(RANK_TAG_NAME) || fields[RANK_TAG_NAME] != TagLib::StringList(rankText))
+        {
+            comment->addField(RANK_TAG_NAME, rankText, true);
+            *aChanged = true;
+        }
+        if(!fields.contains(RATING_TAG_NAME) || fields[RATING_TAG_NAME] != TagLib::StringList(ratingText))
+        {
+            comment->addField(RATING_TAG_NAME, ratingText, true);
+            *aChanged = true;
+        }
+        if(*aChanged && !file.save())
+        {
+            return false;
+        }
+    }
+    else
+    {
+        return false;
+    }
+
+    if(*aChanged)
+    {
+        const TagLib::ByteVector* savedData = stream.data();
+        *aContents = QByteArray(savedData->data(), savedData->size());
+    }
+    return true;
+}
+
+/**
+ * @brief Loads the writes that were left unfinished by a previous session.
+ * @return True if the journal was loaded.
+ */
+bool TagWriter::loadJournal()
+{
+    QFile journalFile(mJournalPath);
+    if(!journalFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream stream(&journalFile);
+    quint32 magic = 0;
+    qint32 numWrites = 0;
+    stream >> magic >> numWrites;
+    if(magic != TAG_WRITE_JOURNAL_MAGIC)
+    {
+        return false;
+    }
+    for(int i = 0; i < numWrites && stream.status() == QDataStream::Ok; i++)
+    {
+        rank_write write;
+        qint32 rank = 0;
+        qint32 numRanked = 0;
+        stream >> write.file_path >> rank >> numRanked;
+        if(stream.status() == QDataStream::Ok)
+        {
+            write.rank = rank;
+            write.num_ranked = numRanked;
+            mPendingWrites.insert(Song::getPathId(write.file_path), write);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Reads the rank from the tags of a file that has been read into memory.
+ * @param aContents The contents of the file.
+ * @param aExtension The extension of the file, in lower case.
+ * @return The rank, or @link UNRANKED UNRANKED@endlink if the file has no rank or can't be parsed.
+ */
+int TagWriter::readRank(const QByteArray& aContents, const QString& aExtension)
+{
+    TagLib::ByteVector data(aContents.constData(), aContents.size());
+    TagLib::ByteVectorStream stream(data);
+    TagLib::String rankText;
+
+    if(aExtension == "mp3")
+    {
+        TagLib::MPEG::File file(&stream, TagLib::ID3v2::FrameFactory::instance(), false);
+        TagLib::ID3v2::UserTextIdentificationFrame* rankFrame = nullptr;
+        if(file.isValid() && file.ID3v2Tag() != nullptr)
+        {
+            rankFrame = TagLib::ID3v2::UserTextIdentificationFrame::find(file.ID3v2Tag(), RANK_TAG_NAME);
+        }
+        if(rankFrame != nullptr && rankFrame->fieldList().size() >= 2)
+        {
+            rankText = rankFrame->fieldList()[1];
+        }
+    }
+    else if(aExtension == "flac")
+    {
+        TagLib::FLAC::File file(&stream, TagLib::ID3v2::FrameFactory::instance(), false);
+        if(file.isValid() && file.xiphComment() != nullptr && file.xiphComment()->contains(RANK_TAG_NAME))
+        {
+            rankText = file.xiphComment()->fieldListMap()[RANK_TAG_NAME].front();
+        }
+    }
+
+    bool isNumber = false;
+    int rank = QString::fromStdWString(rankText.toWString()).toInt(&isNumber);
+    return isNumber ? rank : UNRANKED;
+}
+
+/**
+ * @brief Saves the writes that haven't finished yet. The journal is removed once there are none.
+ *
+ * The file is replaced atomically, so an interrupted save leaves the previous journal in place.
+ */
+void TagWriter::saveJournal()
+{
+    mNumUnsavedWrites = 0;
+    if(mPendingWrites.isEmpty())
+    {
+        QFile::remove(mJournalPath);
+        return;
+    }
+
+    QDir().mkpath(QFileInfo(mJournalPath).absolutePath());
+    QSaveFile journalFile(mJournalPath);
+    if(journalFile.open(QIODevice::WriteOnly))
+    {
+        QDataStream stream(&journalFile);
+        stream << TAG_WRITE_JOURNAL_MAGIC << (qint32)mPendingWrites.count();
+        for(const rank_write& write : mPendingWrites)
+        {
+            stream << write.file_path << (qint32)write.rank << (qint32)write.num_ranked;
+        }
+        journalFile.commit();
+    }
+}
+
+/**
+ * @brief Splits the pending writes into batches and starts a job for each one.
+ */
+void TagWriter::startWriting()
+{
+    mNumFailed = 0;
+    mNumFiles = mPendingWrites.count();
+    mNumFinished = 0;
+    mNumUnsavedWrites = 0;
+
+    // Write the files in path order, which keeps the files of each folder together.
+    QList<rank_write> writes = mPendingWrites.values();
+    std::sort(writes.begin(), writes.end(), [](const rank_write& aFirst, const rank_write& aSecond)
+    {
+        return aFirst.file_path < aSecond.file_path;
+    });
+    QVector<rank_write> batch;
+    for(const rank_write& write : writes)
+    {
+        batch.append(write);
+        if(batch.count() == TAG_WRITE_BATCH_SIZE)
+        {
+            mThreadPool.start(new WriteJob(this, batch));
+            batch.clear();
+        }
+    }
+    if(!batch.isEmpty())
+    {
+        mThreadPool.start(new WriteJob(this, batch));
+    }
+    emit progressChanged(0, mNumFiles);
+}
+
+//-----------------------------------------------
+// WriteJob
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for a WriteJob.
+ * @param aWriter The writer that receives the results.
+ * @param aWrites The ranks to write.
+ */
+TagWriter::WriteJob::WriteJob(TagWriter* aWriter, QVector<rank_write> aWrites) :
+    mWriter(aWriter),
+    mWrites(aWrites)
+{}
+
+/**
+ * @brief Writes the ranks of the batch and reports which files were written.
+ *
+ * If the writer is being destroyed, the job stops early and the files that it didn't get to stay in the journal.
+ */
+void TagWriter::WriteJob::run()
+{
+    QThread::currentThread()->setPriority(QThread::LowPriority);
+
+    QStringList writtenFiles;
+    QStringList failedFiles;
+    for(const rank_write& write : mWrites)
+    {
+        if(mWriter->mStopping)
+        {
+            break;
+        }
+        if(writeRank(write))
+        {
+            writtenFiles.append(write.file_path);
+        }
+        else
+        {
+            failedFiles.append(write.file_path);
+        }
+    }
+    QMetaObject::invokeMethod(mWriter, "on_batchWritten", Qt::QueuedConnection, Q_ARG(QStringList, writtenFiles), Q_ARG(QStringList, failedFiles));
+}
@@ -0,0 +1,88 @@
+#ifndef TAGWRITER_H
+#define TAGWRITER_H
+
+#include <atomic>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QRunnable>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include "songHandling/song.h"
+
+#define RANK_TAG_NAME "SONGSORTER_RANK"
+#define RATING_TAG_NAME "FMPS_RATING"
+#define POPULARIMETER_EMAIL "SongSorter"
+#define MAX_TAG_WRITE_THREADS 4
+#define TAG_WRITE_BATCH_SIZE 16
+#define TAG_WRITE_JOURNAL_INTERVAL 64
+
+class TagWriter : public QObject
+{
+    Q_OBJECT
+
+    public:
+        /**
+         * @brief The rank that should be written into a song file.
+         */
+        typedef struct rank_write
+        {
+            QString file_path; //!< The path of the song file.
+            int rank = UNRANKED; //!< The rank of the song, where 1 is the favorite.
+            int num_ranked = 0; //!< The number of songs that were ranked, which the rating is scaled by.
+        } rank_write;
+
+        explicit TagWriter(QObject *parent = 0);
+        ~TagWriter();
+
+        int getNumPendingWrites() const;
+        bool isWriting() const;
+        bool resumePendingWrites();
+        bool writeRanks(const QList<Song*>& aSongs);
+
+        static double getRating(const rank_write& aWrite);
+        static bool writeRank(const rank_write& aWrite);
+
+    signals:
+        void progressChanged(int aNumFinished, int aNumFiles); //!< Emitted each time a batch of files has been written.
+        void writingFinished(int aNumFailed); //!< Emitted once every file has been written or has failed.
+
+    private slots:
+        void on_batchWritten(QStringList aWrittenFiles, QStringList aFailedFiles);
+
+    private:
+        /**
+         * @brief Writes the ranks of a batch of files on a worker thread.
+         */
+        class WriteJob : public QRunnable
+        {
+            public:
+                WriteJob(TagWriter* aWriter, QVector<rank_write> aWrites);
+                void run() override;
+
+            private:
+                TagWriter* mWriter; //!< The writer that receives the results.
+                QVector<rank_write> mWrites; //!< The ranks to write.
+        };
+
+        bool loadJournal();
+        void saveJournal();
+        void startWriting();
+
+        static bool applyRank(QByteArray* aContents, const QString& aExtension, const rank_write& aWrite, bool* aChanged);
+        static int readRank(const QByteArray& aContents, const QString& aExtension);
+
+        QString mJournalPath; //!< The path of the file that the pending writes are saved to.
+        int mNumFailed = 0; //!< The number of files that couldn't be written since writing started.
+        int mNumFiles = 0; //!< The number of files that were pending when writing started.
+        int mNumFinished = 0; //!< The number of files that have been written or have failed since writing started.
+        int mNumUnsavedWrites = 0; //!< The number of files that have finished since the journal was last saved.
+        QHash<quint64, rank_write> mPendingWrites; //!< The writes that haven't finished yet, keyed by the \link Song::getId id\endlink of the song.
+        std::atomic<bool> mStopping; //!< Set when the writer is being destroyed so that running jobs stop early.
+        QThreadPool mThreadPool; //!< The worker threads that write the files.
+};
+
+#endif // TAGWRITER_H
@@ -0,0 +1,308 @@
+#include "preferencestore.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+
+/**
+  @class PreferenceStore
+  @ingroup sorting
+  @brief Keeps every answer that the user has given about a pair of songs, across sorts.
+
+  Sorts of overlapping sets of songs would otherwise ask about the same pairs again. Each answer is kept as an
+  @link PreferenceStore::preference_edge edge@endlink between the @link PreferenceStore::getSongKey keys@endlink
+  of the two songs, along with how many times each song has won, so that answers that contradict each other can be
+  @link PreferenceStore::getConflicts found@endlink. When a new sort asks for the
+  @link PreferenceStore::getPreferences preferences@endlink among its songs, each pair goes to the song that
+  has won it more often, and pairs that are tied are left out so that the user is asked about them again.
+
+  The edges are kept sorted by their first key, and an index from each key to its first edge is built when the
+  file is read. This means looking up the songs of a sort only touches the edges of those songs. The file isn't
+  read until the store is first used.
+*/
+
+//-----------------------------------------------
+// Static Variable Initialization
+//-----------------------------------------------
+
+static const quint32 PREFERENCE_STORE_MAGIC = 0x53535046; // "SSPF"
+static const qint64 PREFERENCE_EDGE_SIZE = 2 * sizeof(quint64) + 2 * sizeof(quint16); // The size of an edge in the file.
+
+/**
+ * @brief Checks if an edge comes before another in the store's order.
+ * @param aFirst The first edge.
+ * @param aSecond The second edge.
+ * @return True if the first edge's keys come before the second edge's keys.
+ */
+static bool isEdgeBefore(const PreferenceStore::preference_edge& aFirst, const PreferenceStore::preference_edge& aSecond)
+{
+    return (aFirst.first_key != aSecond.first_key) ? aFirst.first_key < aSecond.first_key : aFirst.second_key < aSecond.second_key;
+}
+
+//-----------------------------------------------
+// Constructors and Destructor
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for the PreferenceStore.
+ * @param aStorePath The path of the file that the store is loaded from and saved to.
+ */
+PreferenceStore::PreferenceStore(const QString& aStorePath) :
+    mStorePath(aStorePath)
+{}
+
+/**
+ * @brief Destructor for the PreferenceStore.
+ */
+PreferenceStore::~PreferenceStore()
+{}
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Adds answers from a sort to the store.
+ * @param aJudgments The answers. Each one is the key of the song that was preferred, followed by the key of the other song.
+ *
+ * The answers are sorted and merged into the edges, so this takes time linear in the size of the store.
+ */
+void PreferenceStore::addJudgments(const QList<QPair<quint64, quint64>>& aJudgments)
+{
+    load();
+    QVector<preference_edge> newEdges;
+    newEdges.reserve(aJudgments.count());
+    for(const QPair<quint64, quint64>& judgment : aJudgments)
+    {
+        if(judgment.first == judgment.second)
+        {
+            continue;
+        }
+        preference_edge edge;
+        edge.first_key = qMin(judgment.first, judgment.second);
+        edge.second_key = qMax(judgment.first, judgment.second);
+        edge.first_wins = (judgment.first == edge.first_key) ? 1 : 0;
+        edge.second_wins = 1 - edge.first_wins;
+        newEdges.append(edge);
+    }
+    if(newEdges.isEmpty())
+    {
+        return;
+    }
+    std::sort(newEdges.begin(), newEdges.end(), isEdgeBefore);
+
+    // Merge the new edges into the old ones, and then add up the answers of the edges that are for the same pair.
+    QVector<preference_edge> mergedEdges(mEdges.count() + newEdges.count());
+    std::merge(mEdges.constBegin(), mEdges.constEnd(), newEdges.constBegin(), newEdges.constEnd(), mergedEdges.begin(), isEdgeBefore);
+    int numEdges = 0;
+    for(int i = 0; i < mergedEdges.count(); i++)
+    {
+        preference_edge& lastEdge = mergedEdges[qMax(0, numEdges - 1)];
+        const preference_edge& edge = mergedEdges[i];
+        if(numEdges > 0 && lastEdge.first_key == edge.first_key && lastEdge.second_key == edge.second_key)
+        {
+            lastEdge.first_wins = (quint16)qMin(0xFFFF, lastEdge.first_wins + edge.first_wins);
+            lastEdge.second_wins = (quint16)qMin(0xFFFF, lastEdge.second_wins + edge.second_wins);
+        }
+        else
+        {
+            mergedEdges[numEdges++] = edge;
+        }
+    }
+    mergedEdges.resize(numEdges);
+    mEdges = mergedEdges;
+    buildIndex();
+    mUnsavedChanges = true;
+}
+
+/**
+ * @brief Gets the pairs of songs that have been answered both ways.
+ * @return The edges where each song has won at least once.
+ */
+QList<PreferenceStore::preference_edge> PreferenceStore::getConflicts()
+{
+    load();
+    QList<preference_edge> conflicts;
+    for(const preference_edge& edge : mEdges)
+    {
+        if(edge.first_wins > 0 && edge.second_wins > 0)
+        {
+            conflicts.append(edge);
+        }
+    }
+    return conflicts;
+}
+
+/**
+ * @brief Gets the number of pairs of songs that have been judged.
+ * @return The number of edges in the store.
+ */
+int PreferenceStore::getNumEdges()
+{
+    load();
+    return mEdges.count();
+}
+
+/**
+ * @brief Gets the known preferences among a set of songs.
+ * @param aSongKeys The @link PreferenceStore::getSongKey keys@endlink of the songs.
+ * @return For each pair of songs that is known, keyed by their indices in aSongKeys with the smaller index first,
+ * true if the song with the smaller index is preferred. Pairs that each song has won equally often are left out.
+ *
+ * This takes time linear in the number of songs and the number of edges that they're the first song of.
+ */
+QHash<QPair<int, int>, bool> PreferenceStore::getPreferences(const QVector<quint64>& aSongKeys)
+{
+    load();
+    QHash<quint64, int> songIndices;
+    songIndices.reserve(aSongKeys.count());
+    for(int i = 0; i < aSongKeys.count(); i++)
+    {
+        if(!songIndices.contains(aSongKeys[i]))
+        {
+            songIndices.insert(aSongKeys[i], i);
+        }
+    }
+
+    QHash<QPair<int, int>, bool> preferences;
+    for(QHash<quint64, int>::const_iterator iter = songIndices.constBegin(); iter != songIndices.constEnd(); ++iter)
+    {
+        QHash<quint64, int>::const_iterator edgeIter = mFirstEdges.constFind(iter.key());
+        if(edgeIter == mFirstEdges.constEnd())
+        {
+            continue;
+        }
+        for(int i = *edgeIter; i < mEdges.count() && mEdges[i].first_key == iter.key(); i++)
+        {
+            const preference_edge& edge = mEdges[i];
+            QHash<quint64, int>::const_iterator otherIter = songIndices.constFind(edge.second_key);
+            if(edge.first_wins == edge.second_wins || otherIter == songIndices.constEnd())
+            {
+                continue;
+            }
+            bool firstPreferred = (edge.first_wins > edge.second_wins);
+            if(*iter < *otherIter)
+            {
+                preferences.insert(qMakePair(*iter, *otherIter), firstPreferred);
+            }
+            else
+            {
+                preferences.insert(qMakePair(*otherIter, *iter), !firstPreferred);
+            }
+        }
+    }
+    return preferences;
+}
+
+/**
+ * @brief Saves the store to its file if it has changed.
+ * @return True if the store is saved.
+ *
+ * The file is replaced atomically, so an interrupted save leaves the previous store in place.
+ */
+bool PreferenceStore::save()
+{
+    if(!mUnsavedChanges)
+    {
+        return true;
+    }
+
+    QSaveFile storeFile(mStorePath);
+    if(!storeFile.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+
+    QDataStream stream(&storeFile);
+    stream << PREFERENCE_STORE_MAGIC << (qint32)PREFERENCE_STORE_VERSION << (qint32)mEdges.count();
+    for(const preference_edge& edge : mEdges)
+    {
+        stream << edge.first_key << edge.second_key << edge.first_wins << edge.second_wins;
+    }
+
+    mUnsavedChanges = !storeFile.commit();
+    return !mUnsavedChanges;
+}
+
+/**
+ * @brief Gets the key that identifies a song in the store.
+ * @param aSong The song.
+ * @return The song's @link Song::getId id@endlink.
+ *
+ * Songs are keyed by their files rather than by their names, so that answers about one version of a song, such
+ * as a live recording, are never reused for another version with the same artist and name. The trade-off is
+ * that answers don't follow a file that is moved or renamed.
+ */
+quint64 PreferenceStore::getSongKey(const Song* aSong)
+{
+    return aSong->getId();
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Rebuilds the index from each song to its first edge.
+ */
+void PreferenceStore::buildIndex()
+{
+    mFirstEdges.clear();
+    mFirstEdges.reserve(mEdges.count());
+    for(int i = 0; i < mEdges.count(); i++)
+    {
+        if(i == 0 || mEdges[i].first_key != mEdges[i - 1].first_key)
+        {
+            mFirstEdges.insert(mEdges[i].first_key, i);
+        }
+    }
+}
+
+/**
+ * @brief Loads the store from its file the first time that it's used.
+ * @return True if the store was read from its file. False if it was already read, or the file doesn't exist or is from another version.
+ */
+bool PreferenceStore::load()
+{
+    if(mIsLoaded)
+    {
+        return false;
+    }
+    mIsLoaded = true;
+
+    QFile storeFile(mStorePath);
+    if(!storeFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream stream(&storeFile);
+    quint32 magic = 0;
+    qint32 version = 0;
+    qint32 numEdges = 0;
+    stream >> magic >> version >> numEdges;
+    if(magic != PREFERENCE_STORE_MAGIC || version != PREFERENCE_STORE_VERSION || numEdges < 0)
+    {
+        return false;
+    }
+
+    // The count comes from the file, so don't trust it further than the file's size allows.
+    mEdges.reserve((int)qMin<qint64>(numEdges, storeFile.size() / PREFERENCE_EDGE_SIZE));
+    for(int i = 0; i < numEdges && stream.status() == QDataStream::Ok; i++)
+    {
+        preference_edge edge;
+        stream >> edge.first_key >> edge.second_key >> edge.first_wins >> edge.second_wins;
+        if(stream.status() == QDataStream::Ok && edge.first_key < edge.second_key)
+        {
+            mEdges.append(edge);
+        }
+    }
+
+    // The file is saved in order, but sort it anyway in case it was cut short or edited.
+    if(!std::is_sorted(mEdges.constBegin(), mEdges.constEnd(), isEdgeBefore))
+    {
+        std::sort(mEdges.begin(), mEdges.end(), isEdgeBefore);
+    }
+    buildIndex();
+    return true;
+}
@@ -0,0 +1,52 @@
+#ifndef PREFERENCESTORE_H
+#define PREFERENCESTORE_H
+
+#include <algorithm>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVector>
+#include "songHandling/song.h"
+
+#define PREFERENCE_STORE_VERSION 2
+
+class PreferenceStore
+{
+    public:
+        /**
+         * @brief Every answer that has been given about a pair of songs.
+         *
+         * The songs are identified by their @link PreferenceStore::getSongKey keys@endlink, with the smaller key first.
+         */
+        typedef struct preference_edge
+        {
+            quint64 first_key = 0; //!< The key of the first song.
+            quint64 second_key = 0; //!< The key of the second song. Always greater than the first key.
+            quint16 first_wins = 0; //!< The number of times that the first song was preferred.
+            quint16 second_wins = 0; //!< The number of times that the second song was preferred.
+        } preference_edge;
+
+        explicit PreferenceStore(const QString& aStorePath);
+        ~PreferenceStore();
+
+        void addJudgments(const QList<QPair<quint64, quint64>>& aJudgments);
+        QList<preference_edge> getConflicts();
+        int getNumEdges();
+        QHash<QPair<int, int>, bool> getPreferences(const QVector<quint64>& aSongKeys);
+        bool save();
+
+        static quint64 getSongKey(const Song* aSong);
+
+    private:
+        void buildIndex();
+        bool load();
+
+        QVector<preference_edge> mEdges; //!< Every pair of songs that has been judged, sorted by first key and then by second key.
+        QHash<quint64, int> mFirstEdges; //!< The index of the first edge of each song that is the first song of an edge.
+        bool mIsLoaded = false; //!< Whether or not the store has been read from its file yet. It's read on first use.
+        QString mStorePath; //!< The path of the file that the store is loaded from and saved to.
+        bool mUnsavedChanges = false; //!< Whether or not judgments have been added since the store was last saved.
+};
+
+#endif // PREFERENCESTORE_H
@@ -0,0 +1,1074 @@
+#include "rankingengine.h"
+
+/**
+  @class RankingEngine
+  @ingroup sorting
+  @brief Determines the order of a set of items using the user's preferences.
+
+  The RankingEngine is a merge sort that is driven by the user. Items are identified by their index
+  (0 to n - 1), so the engine does not depend on how the caller stores its @link Song songs@endlink.
+
+  Rather than asking for a single pairwise comparison at a time, the engine exposes a
+  @link RankingEngine::getFrontier frontier@endlink of independent @link RankingEngine::comparison_group groups@endlink.
+  Each group holds up to @link RankingEngine::getBatchSize batch size@endlink items that the user orders
+  in one interaction:
+  @n - Unsorted items are first split into chunks of the batch size, and each chunk is fully ordered at once.
+  @n - Sorted runs are then merged in pairs. Each interaction on a merge orders a window from the head of both
+  runs, which can settle several items at once instead of a single one.
+
+  With a batch size of 2 this is a plain pairwise merge sort.
+
+  Items that are added after a sort has finished don't need the whole sort to start over. The engine can be
+  @link RankingEngine::resetWithRanking reset with the finished ranking@endlink, in which case each new item
+  is inserted into it by a search: every interaction shows the item with up to batch size - 1 evenly spaced
+  pivots from the part of the ranking that it could still go in, and its place among the pivots narrows
+  that part down. With a batch size of 2 this is a binary search, which takes about log2(n) interactions per item.
+
+  Items that belong together, such as the songs of an album, can be @link RankingEngine::resetWithGroups sorted
+  hierarchically@endlink. Each group is sorted on its own before the next one is started, so the user sees the items of
+  one group back to back instead of jumping between unrelated items. The sorted groups are then merged, always taking
+  the two smallest runs. As with Huffman coding, this is the order of pairwise merges that takes the fewest interactions
+  when the groups have different sizes, and when they have the same size it takes as many as a tournament tree over
+  the groups would.
+
+  The engine keeps @link RankingEngine::getRemainingInteractions bounds@endlink on the number of interactions that
+  are left, which can be read in constant time. The bounds of the tasks that haven't started yet are worked out
+  when the sort is reset, assuming that groups are answered in the order that
+  @link RankingEngine::getNextGroup getNextGroup@endlink gives them. The bounds of the active tasks are kept as
+  running sums that each decision updates.
+
+  Every decision records what it changed in a journal, so the last N decisions can be
+  @link RankingEngine::undo undone@endlink in O(N) no matter how long the session has been. Any order that
+  was inferred from an undone decision, such as the tail of a run being appended once the other run ran
+  out, is taken back with it.
+*/
+
+//-----------------------------------------------
+// Constructors and Destructor
+//-----------------------------------------------
+
+/**
+ * @brief Constructor for the RankingEngine.
+ * @param aNumItems The number of items to rank.
+ * @param aBatchSize The maximum number of items that the user orders in a single interaction.
+ */
+RankingEngine::RankingEngine(int aNumItems, int aBatchSize)
+{
+    reset(aNumItems, aBatchSize);
+}
+
+/**
+ * @brief Destructor for the RankingEngine.
+ */
+RankingEngine::~RankingEngine()
+{}
+
+//-----------------------------------------------
+// Public Functions
+//-----------------------------------------------
+
+/**
+ * @brief Checks if there are decisions that can be undone.
+ * @return True if at least one ordering has been submitted since the sort started.
+ */
+bool RankingEngine::canUndo() const
+{
+    return !mJournal.isEmpty();
+}
+
+/**
+ * @brief Gets the maximum number of items in a comparison group.
+ * @return The batch size of the engine.
+ */
+int RankingEngine::getBatchSize() const
+{
+    return mBatchSize;
+}
+
+/**
+ * @brief Gets every comparison group that is currently waiting on the user.
+ * @return A list of independent groups. They can be answered in any order.
+ */
+QList<RankingEngine::comparison_group> RankingEngine::getFrontier() const
+{
+    QList<comparison_group> frontier;
+    for(const sort_task& task : mActiveTasks)
+    {
+        frontier.append(buildGroup(task));
+    }
+    return frontier;
+}
+
+/**
+ * @brief Gets the next comparison group that should be shown to the user.
+ * @return The first group in the frontier, or an empty group if the sort is finished.
+ */
+RankingEngine::comparison_group RankingEngine::getNextGroup() const
+{
+    if(mActiveTasks.isEmpty())
+    {
+        return comparison_group();
+    }
+    return buildGroup(mActiveTasks.first());
+}
+
+/**
+ * @brief Gets the number of orderings that the user has submitted so far.
+ * @return The number of interactions.
+ */
+int RankingEngine::getNumInteractions() const
+{
+    return mNumInteractions;
+}
+
+/**
+ * @brief Gets the order of the items that has been inferred so far.
+ * @return Chains of items, each ordered from best to worst. Every order that the engine knows of is implied by
+ * the chains, and items that haven't been placed relative to anything yet are chains of their own.
+ *
+ * Unlike the bounds, this takes time linear in the number of items.
+ */
+QList<QVector<int>> RankingEngine::getPartialOrder() const
+{
+    QList<QVector<int>> chains = mGroupRuns + mPendingRuns;
+    for(const QVector<int>& group : mWaitingGroups)
+    {
+        for(int item : group)
+        {
+            chains.append(QVector<int>() << item);
+        }
+    }
+    for(const sort_task& task : mActiveTasks)
+    {
+        if(task.is_chunk)
+        {
+            for(int item : task.left)
+            {
+                chains.append(QVector<int>() << item);
+            }
+        }
+        else if(task.is_insertion)
+        {
+            // The item being inserted is known to go between the ends of its range.
+            chains.append(task.left);
+            QVector<int> currentChain;
+            if(task.left_pos > 0)
+            {
+                currentChain.append(task.left[task.left_pos - 1]);
+            }
+            currentChain.append(task.right.first());
+            if(task.right_pos < task.left.count())
+            {
+                currentChain.append(task.left[task.right_pos]);
+            }
+            chains.append(currentChain);
+            for(int i = 1; i < task.right.count(); i++)
+            {
+                chains.append(QVector<int>() << task.right[i]);
+            }
+        }
+        else
+        {
+            // The merged items come before whatever is left of either run.
+            chains.append(task.output + task.left.mid(task.left_pos));
+            chains.append(task.output + task.right.mid(task.right_pos));
+        }
+    }
+    return chains;
+}
+
+/**
+ * @brief Gets the items that are likely to be shown after the next group.
+ * @return The items that follow the windows of the next group's runs, and the items of the group after it.
+ *
+ * This is meant for loading resources ahead of time, such as artwork.
+ */
+QVector<int> RankingEngine::getUpcomingItems() const
+{
+    QVector<int> upcomingItems;
+    if(!mActiveTasks.isEmpty())
+    {
+        // The window of each run moves forward past the items that are merged out of it.
+        const sort_task& task = mActiveTasks.first();
+        if(task.is_insertion)
+        {
+            upcomingItems += task.right.mid(1, 1);
+        }
+        else if(!task.is_chunk)
+        {
+            upcomingItems += task.left.mid(task.left_pos + getWindowSize(true), 1);
+            upcomingItems += task.right.mid(task.right_pos + getWindowSize(false), 1);
+        }
+    }
+    if(mActiveTasks.count() > 1)
+    {
+        upcomingItems += buildGroup(mActiveTasks[1]).items;
+    }
+    return upcomingItems;
+}
+
+/**
+ * @brief Gets the final order of the items.
+ * @return The items ordered from best to worst, or an empty vector if the sort is not finished.
+ */
+QVector<int> RankingEngine::getRanking() const
+{
+    if(!isFinished() || mPendingRuns.count() + mGroupRuns.count() == 0)
+    {
+        return QVector<int>();
+    }
+    return mPendingRuns.isEmpty() ? mGroupRuns.first() : mPendingRuns.first();
+}
+
+/**
+ * @brief Gets bounds on the number of interactions that are left. This takes constant time.
+ * @param aLowerBound Set to the fewest interactions that can finish the sort.
+ * @param aUpperBound Set to the most interactions that the sort can still take.
+ *
+ * The bounds assume that the groups are answered in the order that @link RankingEngine::getNextGroup getNextGroup@endlink
+ * gives them. Both are 0 once the sort is finished.
+ */
+void RankingEngine::getRemainingInteractions(int* aLowerBound, int* aUpperBound) const
+{
+    *aLowerBound = mActiveLowerBound + mFutureLowerBounds.value(mNextTaskId);
+    *aUpperBound = mActiveUpperBound + mFutureUpperBounds.value(mNextTaskId);
+}
+
+/**
+ * @brief Checks if every item has been ranked.
+ * @return True if no more input is needed from the user.
+ */
+bool RankingEngine::isFinished() const
+{
+    return mActiveTasks.isEmpty() && mWaitingGroups.isEmpty() && mPendingRuns.count() + mGroupRuns.count() <= 1;
+}
+
+/**
+ * @brief Checks if the items are sorted within their groups before the groups are merged.
+ * @return True if the sort was started with @link RankingEngine::resetWithGroups resetWithGroups@endlink.
+ */
+bool RankingEngine::isHierarchical() const
+{
+    return mIsHierarchical;
+}
+
+/**
+ * @brief Works out which group would be shown next if the user submitted an ordering.
+ * @param aTaskId The @link RankingEngine::comparison_group::task_id task id@endlink of the group.
+ * @param aOrderedItems The items of the group, ordered from best to worst.
+ * @return The group that @link RankingEngine::getNextGroup getNextGroup@endlink would return after the ordering,
+ * or an empty group if the ordering would finish the sort or isn't valid.
+ *
+ * The ordering is applied and then undone through the journal, so the engine is left exactly as it was. This
+ * lets the caller prepare the groups that can follow the current one while the user is still deciding.
+ */
+RankingEngine::comparison_group RankingEngine::predictNextGroup(int aTaskId, const QVector<int>& aOrderedItems)
+{
+    if(!submitOrdering(aTaskId, aOrderedItems))
+    {
+        return comparison_group();
+    }
+    comparison_group nextGroup = getNextGroup();
+    undoDecision();
+    return nextGroup;
+}
+
+/**
+ * @brief Starts a new sort.
+ * @param aNumItems The number of items to rank.
+ * @param aBatchSize The maximum number of items that the user orders in a single interaction.
+ * This is clamped between @link PAIRWISE_BATCH_SIZE 2@endlink and @link MAX_BATCH_SIZE 6@endlink.
+ */
+void RankingEngine::reset(int aNumItems, int aBatchSize)
+{
+    mBatchSize = qBound(PAIRWISE_BATCH_SIZE, aBatchSize, MAX_BATCH_SIZE);
+    mActiveLowerBound = 0;
+    mActiveUpperBound = 0;
+    mIsHierarchical = false;
+    mNextTaskId = 0;
+    mNumInitiallyRanked = 0;
+    mNumInteractions = 0;
+    mNumItems = qMax(0, aNumItems);
+    mActiveTasks.clear();
+    mGroupRuns.clear();
+    mInsertionLowerBounds.clear();
+    mInsertionUpperBounds.clear();
+    mJournal.clear();
+    mPendingRuns.clear();
+    mSearchBounds.clear();
+    mWaitingGroups.clear();
+
+    QVector<int> items;
+    for(int item = 0; item < mNumItems; item++)
+    {
+        items.append(item);
+    }
+    addChunks(items);
+
+    // The state that a sort starts in can't be undone, so what starting the merges changes isn't journaled.
+    decision_delta delta;
+    startMerges(&delta);
+    planFutureTasks();
+}
+
+/**
+ * @brief Starts a sort that ranks the items within each group before ranking the groups against each other.
+ * @param aGroups The items of each group, such as the songs of an album. The groups are sorted in this order.
+ * @param aNumItems The number of items. Items that aren't in any group are sorted as one more group after the last one.
+ * @param aBatchSize The maximum number of items that the user orders in a single interaction.
+ *
+ * Only one group is sorted at a time, so every comparison group that is shown until a group is finished comes from
+ * that group. Once every group is sorted, the runs of the groups are merged smallest first.
+ */
+void RankingEngine::resetWithGroups(const QList<QVector<int>>& aGroups, int aNumItems, int aBatchSize)
+{
+    reset(0, aBatchSize);
+    mNumItems = qMax(0, aNumItems);
+    mIsHierarchical = true;
+
+    QVector<bool> isGrouped(mNumItems, false);
+    for(const QVector<int>& group : aGroups)
+    {
+        for(int item : group)
+        {
+            if(item < 0 || item >= mNumItems || isGrouped[item])
+            {
+                Q_ASSERT_X(false, "RankingEngine::resetWithGroups", "A group has an item that is out of range or in another group!");
+                reset(aNumItems, aBatchSize);
+                return;
+            }
+            isGrouped[item] = true;
+        }
+        if(!group.isEmpty())
+        {
+            mWaitingGroups.append(group);
+        }
+    }
+    QVector<int> ungroupedItems;
+    for(int item = 0; item < mNumItems; item++)
+    {
+        if(!isGrouped[item])
+        {
+            ungroupedItems.append(item);
+        }
+    }
+    if(!ungroupedItems.isEmpty())
+    {
+        mWaitingGroups.append(ungroupedItems);
+    }
+
+    decision_delta delta;
+    startMerges(&delta);
+    planFutureTasks();
+}
+
+/**
+ * @brief Starts a sort that inserts new items into a finished ranking.
+ * @param aRanking The items that are already ranked, from best to worst.
+ * @param aNumItems The number of items, including the ranked ones. Items that aren't in the ranking are inserted into it.
+ * @param aBatchSize The maximum number of items that the user orders in a single interaction.
+ *
+ * If nothing is ranked yet, this is the same as @link RankingEngine::reset reset@endlink.
+ */
+void RankingEngine::resetWithRanking(const QVector<int>& aRanking, int aNumItems, int aBatchSize)
+{
+    reset(0, aBatchSize);
+    mNumItems = qMax(0, aNumItems);
+
+    // Find the items that aren't ranked yet.
+    QVector<bool> isRanked(mNumItems, false);
+    sort_task task;
+    for(int item : aRanking)
+    {
+        if(item < 0 || item >= mNumItems || isRanked[item])
+        {
+            Q_ASSERT_X(false, "RankingEngine::resetWithRanking", "The ranking has an item that is out of range or repeated!");
+            reset(aNumItems, aBatchSize);
+            return;
+        }
+        isRanked[item] = true;
+        task.left.append(item);
+    }
+    for(int item = 0; item < mNumItems; item++)
+    {
+        if(!isRanked[item])
+        {
+            task.right.append(item);
+        }
+    }
+
+    if(task.left.isEmpty())
+    {
+        reset(aNumItems, aBatchSize);
+    }
+    else if(task.right.isEmpty())
+    {
+        mPendingRuns.append(task.left);
+    }
+    else
+    {
+        // Work out the bounds of inserting each item, given how many items are ranked by the time it's inserted.
+        mNumInitiallyRanked = task.left.count();
+        mInsertionLowerBounds = QVector<int>(task.right.count() + 1, 0);
+        mInsertionUpperBounds = QVector<int>(task.right.count() + 1, 0);
+        for(int i = task.right.count() - 1; i >= 0; i--)
+        {
+            int lowerBound = 0;
+            int upperBound = 0;
+            getSearchBounds(mNumInitiallyRanked + i, &lowerBound, &upperBound);
+            mInsertionLowerBounds[i] = mInsertionLowerBounds[i + 1] + lowerBound;
+            mInsertionUpperBounds[i] = mInsertionUpperBounds[i + 1] + upperBound;
+        }
+
+        task.id = mNextTaskId++;
+        task.is_insertion = true;
+        task.left_pos = 0;
+        task.right_pos = task.left.count();
+        mActiveTasks.append(task);
+        addTaskBounds(task, 1);
+    }
+}
+
+/**
+ * @brief Applies the user's ordering of a comparison group.
+ * @param aTaskId The @link RankingEngine::comparison_group::task_id task id@endlink of the group.
+ * @param aOrderedItems The items of the group, ordered from best to worst.
+ * @return True if the ordering was applied. False if the task doesn't exist or the items don't match the group.
+ */
+bool RankingEngine::submitOrdering(int aTaskId, const QVector<int>& aOrderedItems)
+{
+    // Find the task.
+    int taskIndex = -1;
+    for(int i = 0; i < mActiveTasks.count(); i++)
+    {
+        if(mActiveTasks[i].id == aTaskId)
+        {
+            taskIndex = i;
+            break;
+        }
+    }
+    if(taskIndex < 0)
+    {
+        return false;
+    }
+
+    // Make sure that the ordering contains exactly the items of the group.
+    QVector<int> expectedItems = buildGroup(mActiveTasks[taskIndex]).items;
+    QVector<int> submittedItems = aOrderedItems;
+    std::sort(expectedItems.begin(), expectedItems.end());
+    std::sort(submittedItems.begin(), submittedItems.end());
+    if(expectedItems != submittedItems)
+    {
+        Q_ASSERT_X(false, "RankingEngine::submitOrdering", "The submitted ordering doesn't match the comparison group!");
+        return false;
+    }
+
+    // Remember the state of the task so that the decision can be undone. The task's bounds are added back
+    // once the decision has been applied, unless the decision finishes it.
+    mNumInteractions++;
+    sort_task& task = mActiveTasks[taskIndex];
+    addTaskBounds(task, -1);
+    decision_delta delta;
+    delta.task_index = taskIndex;
+    delta.left_pos = task.left_pos;
+    delta.right_pos = task.right_pos;
+    delta.output_size = task.output.count();
+
+    if(task.is_chunk)
+    {
+        // A chunk is fully ordered by a single interaction.
+        task.output = aOrderedItems;
+        delta.finished_task = true;
+        delta.task = task;
+        finishTask(taskIndex, &delta);
+        mJournal.append(delta);
+        return true;
+    }
+
+    if(task.is_insertion)
+    {
+        // The new item goes after every pivot that the user put ahead of it, and before the rest.
+        QVector<int> pivots = getPivotPositions(task);
+        int itemPosition = aOrderedItems.indexOf(task.right.first());
+        int numBetterPivots = 0;
+        for(int pivot : pivots)
+        {
+            if(aOrderedItems.indexOf(task.left[pivot]) < itemPosition)
+            {
+                numBetterPivots++;
+            }
+        }
+        if(numBetterPivots > 0)
+        {
+            task.left_pos = pivots[numBetterPivots - 1] + 1;
+        }
+        if(numBetterPivots < pivots.count())
+        {
+            task.right_pos = pivots[numBetterPivots];
+        }
+
+        // Once there's only one place left, insert the item and move on to the next one.
+        if(task.left_pos >= task.right_pos)
+        {
+            delta.inserted_pos = task.left_pos;
+            task.left.insert(task.left_pos, task.right.takeFirst());
+            task.left_pos = 0;
+            task.right_pos = task.left.count();
+            if(task.right.isEmpty())
+            {
+                task.output = task.left;
+                delta.finished_task = true;
+                delta.task = task;
+                finishTask(taskIndex, &delta);
+            }
+        }
+        if(!delta.finished_task)
+        {
+            addTaskBounds(task, 1);
+        }
+        mJournal.append(delta);
+        return true;
+    }
+
+    // Only the order across the two runs matters, since each run is already sorted. Merge the
+    // windows by comparing where the user placed each head until one of the windows runs out.
+    QHash<int, int> positions;
+    for(int i = 0; i < aOrderedItems.count(); i++)
+    {
+        positions.insert(aOrderedItems[i], i);
+    }
+    int leftEnd = qMin(task.left_pos + getWindowSize(true), task.left.count());
+    int rightEnd = qMin(task.right_pos + getWindowSize(false), task.right.count());
+    while(task.left_pos < leftEnd && task.right_pos < rightEnd)
+    {
+        if(positions.value(task.left[task.left_pos]) < positions.value(task.right[task.right_pos]))
+        {
+            task.output.append(task.left[task.left_pos++]);
+        }
+        else
+        {
+            task.output.append(task.right[task.right_pos++]);
+        }
+    }
+
+    // Once either run is used up, the rest of the other run can be appended as is.
+    if(task.left_pos == task.left.count() || task.right_pos == task.right.count())
+    {
+        task.output += task.left.mid(task.left_pos);
+        task.output += task.right.mid(task.right_pos);
+        task.left_pos = task.left.count();
+        task.right_pos = task.right.count();
+        delta.finished_task = true;
+        delta.task = task;
+        finishTask(taskIndex, &delta);
+    }
+    else
+    {
+        addTaskBounds(task, 1);
+    }
+
+    mJournal.append(delta);
+    return true;
+}
+
+/**
+ * @brief Undoes the most recent decisions.
+ * @param aNumDecisions The number of decisions to undo.
+ * @return The number of decisions that were undone. This is less than aNumDecisions if there weren't enough decisions.
+ */
+int RankingEngine::undo(int aNumDecisions)
+{
+    int numUndone = 0;
+    while(numUndone < aNumDecisions && !mJournal.isEmpty())
+    {
+        undoDecision();
+        numUndone++;
+    }
+    return numUndone;
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Splits unsorted items into chunks of the batch size and starts a chunk task for each of them.
+ * @param aItems The items, in the order that they should be shown.
+ *
+ * A chunk with a single item is already sorted, so it's added to the pending runs instead. Only the last chunk can be that small.
+ */
+void RankingEngine::addChunks(const QVector<int>& aItems)
+{
+    for(int first = 0; first < aItems.count(); first += mBatchSize)
+    {
+        QVector<int> chunk = aItems.mid(first, mBatchSize);
+        if(chunk.count() == 1)
+        {
+            mPendingRuns.append(chunk);
+        }
+        else
+        {
+            sort_task task;
+            task.id = mNextTaskId++;
+            task.is_chunk = true;
+            task.left = chunk;
+            mActiveTasks.append(task);
+            addTaskBounds(task, 1);
+        }
+    }
+}
+
+/**
+ * @brief Adds the bounds of an active task to the running sums, or takes them out.
+ * @param aTask The task.
+ * @param aSign 1 to add the bounds, or -1 to take them out.
+ */
+void RankingEngine::addTaskBounds(const sort_task& aTask, int aSign)
+{
+    int lowerBound = 0;
+    int upperBound = 0;
+    getTaskBounds(aTask, &lowerBound, &upperBound);
+    mActiveLowerBound += aSign * lowerBound;
+    mActiveUpperBound += aSign * upperBound;
+}
+
+/**
+ * @brief Builds the comparison group that will advance a task.
+ * @param aTask The task to build the group for.
+ * @return The whole chunk for a chunk task, the windows at the heads of both runs for a merge task, or the
+ * item being inserted followed by its pivots for an insertion task.
+ */
+RankingEngine::comparison_group RankingEngine::buildGroup(const sort_task& aTask) const
+{
+    comparison_group group;
+    group.task_id = aTask.id;
+    if(aTask.is_chunk)
+    {
+        group.items = aTask.left;
+    }
+    else if(aTask.is_insertion)
+    {
+        group.items.append(aTask.right.first());
+        for(int pivot : getPivotPositions(aTask))
+        {
+            group.items.append(aTask.left[pivot]);
+        }
+    }
+    else
+    {
+        group.items = aTask.left.mid(aTask.left_pos, getWindowSize(true));
+        group.items += aTask.right.mid(aTask.right_pos, getWindowSize(false));
+    }
+    return group;
+}
+
+/**
+ * @brief Turns the output of a finished task into a sorted run and starts any tasks that are now possible.
+ * @param aTaskIndex The index of the task in the @link RankingEngine::mActiveTasks active task list@endlink.
+ * @param aDelta The delta of the decision that finished the task. The tasks that were started are recorded in it.
+ */
+void RankingEngine::finishTask(int aTaskIndex, decision_delta* aDelta)
+{
+    mPendingRuns.append(mActiveTasks.takeAt(aTaskIndex).output);
+    startMerges(aDelta);
+}
+
+/**
+ * @brief Finds the smallest of the group runs.
+ * @return The index of the smallest group run. Ties go to the run that has been waiting the longest.
+ */
+int RankingEngine::findSmallestGroupRun() const
+{
+    return std::min_element(mGroupRuns.begin(), mGroupRuns.end(), [](const QVector<int>& aFirst, const QVector<int>& aSecond)
+    {
+        return aFirst.count() < aSecond.count();
+    }) - mGroupRuns.begin();
+}
+
+/**
+ * @brief Gets bounds on the number of interactions that merging two runs takes.
+ * @param aLeftSize The number of items left in the left run.
+ * @param aRightSize The number of items left in the right run.
+ * @param aLowerBound Set to the fewest interactions, which is when one run is used up as fast as possible.
+ * @param aUpperBound Set to the most interactions, which is when each interaction only uses up one of the windows.
+ */
+void RankingEngine::getMergeBounds(int aLeftSize, int aRightSize, int* aLowerBound, int* aUpperBound) const
+{
+    if(aLeftSize <= 0 || aRightSize <= 0)
+    {
+        *aLowerBound = 0;
+        *aUpperBound = 0;
+        return;
+    }
+    int leftWindows = (aLeftSize + getWindowSize(true) - 1) / getWindowSize(true);
+    int rightWindows = (aRightSize + getWindowSize(false) - 1) / getWindowSize(false);
+    *aLowerBound = qMin(leftWindows, rightWindows);
+    *aUpperBound = leftWindows + rightWindows - 1;
+}
+
+/**
+ * @brief Gets the positions in the ranked run that the item being inserted is compared against.
+ * @param aTask The insertion task.
+ * @return Up to batch size - 1 positions, in increasing order, spread evenly over the part of the run that the
+ * item could still go in. With one pivot, this is the middle of that part.
+ */
+QVector<int> RankingEngine::getPivotPositions(const sort_task& aTask) const
+{
+    QVector<int> pivots;
+    int rangeSize = aTask.right_pos - aTask.left_pos;
+    int numPivots = qMin(mBatchSize - 1, rangeSize);
+    for(int i = 1; i <= numPivots; i++)
+    {
+        pivots.append(aTask.left_pos + ((2 * i - 1) * rangeSize) / (2 * numPivots));
+    }
+    return pivots;
+}
+
+/**
+ * @brief Gets bounds on the number of interactions that finding the place of an item takes.
+ * @param aRangeSize The number of ranked items that the item could still go between.
+ * @param aLowerBound Set to the fewest interactions, along the shortest path of the search.
+ * @param aUpperBound Set to the most interactions, along the longest path of the search.
+ *
+ * The results are memoized, since every range that the search can narrow down to is looked up again as it does.
+ */
+void RankingEngine::getSearchBounds(int aRangeSize, int* aLowerBound, int* aUpperBound) const
+{
+    *aLowerBound = 0;
+    *aUpperBound = 0;
+    if(aRangeSize <= 0)
+    {
+        return;
+    }
+    QHash<int, QPair<int, int>>::const_iterator iter = mSearchBounds.constFind(aRangeSize);
+    if(iter != mSearchBounds.constEnd())
+    {
+        *aLowerBound = iter->first;
+        *aUpperBound = iter->second;
+        return;
+    }
+
+    // Each interaction narrows the range down to the part between two neighbouring pivots. This matches getPivotPositions.
+    int numPivots = qMin(mBatchSize - 1, aRangeSize);
+    int lowerBound = aRangeSize;
+    int upperBound = 0;
+    int previousPivot = -1;
+    for(int i = 1; i <= numPivots + 1; i++)
+    {
+        int pivot = (i <= numPivots) ? ((2 * i - 1) * aRangeSize) / (2 * numPivots) : aRangeSize;
+        int partLowerBound = 0;
+        int partUpperBound = 0;
+        getSearchBounds(pivot - previousPivot - 1, &partLowerBound, &partUpperBound);
+        lowerBound = qMin(lowerBound, partLowerBound);
+        upperBound = qMax(upperBound, partUpperBound);
+        previousPivot = pivot;
+    }
+    *aLowerBound = lowerBound + 1;
+    *aUpperBound = upperBound + 1;
+    mSearchBounds.insert(aRangeSize, qMakePair(*aLowerBound, *aUpperBound));
+}
+
+/**
+ * @brief Gets bounds on the number of interactions that a task has left.
+ * @param aTask The task.
+ * @param aLowerBound Set to the fewest interactions that can finish the task.
+ * @param aUpperBound Set to the most interactions that the task can still take.
+ */
+void RankingEngine::getTaskBounds(const sort_task& aTask, int* aLowerBound, int* aUpperBound) const
+{
+    if(aTask.is_chunk)
+    {
+        // A chunk is ordered in a single interaction.
+        *aLowerBound = 1;
+        *aUpperBound = 1;
+    }
+    else if(aTask.is_insertion)
+    {
+        *aLowerBound = 0;
+        *aUpperBound = 0;
+        if(!aTask.right.isEmpty())
+        {
+            int numInserted = aTask.left.count() - mNumInitiallyRanked;
+            getSearchBounds(aTask.right_pos - aTask.left_pos, aLowerBound, aUpperBound);
+            *aLowerBound += mInsertionLowerBounds.value(numInserted + 1);
+            *aUpperBound += mInsertionUpperBounds.value(numInserted + 1);
+        }
+    }
+    else
+    {
+        getMergeBounds(aTask.left.count() - aTask.left_pos, aTask.right.count() - aTask.right_pos, aLowerBound, aUpperBound);
+    }
+}
+
+/**
+ * @brief Gets the number of items taken from the head of a run for a merge group.
+ * @param aLeftRun True to get the window of the left run, false to get the window of the right run.
+ * @return Half of the batch size. The left run gets the extra item when the batch size is odd.
+ */
+int RankingEngine::getWindowSize(bool aLeftRun) const
+{
+    return aLeftRun ? (mBatchSize + 1) / 2 : mBatchSize / 2;
+}
+
+/**
+ * @brief Works out the bounds of the tasks that haven't been started yet.
+ *
+ * The size of the run that each task produces doesn't depend on the user's answers, so the merges that will be
+ * started, and the size of their runs, follow from the order that the tasks finish in. This plays that out for
+ * tasks that finish in the order they were started, and sums up the bounds of the tasks from each task id on.
+ * In a hierarchical sort, the groups that are waiting are played out the same way, followed by the merges between
+ * the groups.
+ */
+void RankingEngine::planFutureTasks()
+{
+    // Only the tasks with ids from mNextTaskId on haven't been started.
+    mFutureLowerBounds = QVector<int>(mNextTaskId, 0);
+    mFutureUpperBounds = QVector<int>(mNextTaskId, 0);
+
+    QList<int> taskSizes;
+    for(const sort_task& task : mActiveTasks)
+    {
+        taskSizes.append(task.left.count() + task.right.count());
+    }
+    QList<int> runSizes;
+    for(const QVector<int>& run : mPendingRuns)
+    {
+        runSizes.append(run.count());
+    }
+    int lastRunSize = planMerges(taskSizes, runSizes);
+
+    if(mIsHierarchical)
+    {
+        // The run of the group being sorted joins the group runs, and then each waiting group is chunked and sorted.
+        QList<int> groupRunSizes;
+        for(const QVector<int>& run : mGroupRuns)
+        {
+            groupRunSizes.append(run.count());
+        }
+        if(lastRunSize > 0)
+        {
+            groupRunSizes.append(lastRunSize);
+        }
+        for(const QVector<int>& group : mWaitingGroups)
+        {
+            QList<int> chunkSizes;
+            QList<int> singleItemRunSizes;
+            for(int first = 0; first < group.count(); first += mBatchSize)
+            {
+                int chunkSize = qMin(mBatchSize, group.count() - first);
+                if(chunkSize == 1)
+                {
+                    singleItemRunSizes.append(chunkSize);
+                }
+                else
+                {
+                    chunkSizes.append(chunkSize);
+                    mFutureLowerBounds.append(1);
+                    mFutureUpperBounds.append(1);
+                }
+            }
+            groupRunSizes.append(planMerges(chunkSizes, singleItemRunSizes));
+        }
+
+        // The two smallest group runs are merged until one is left, the same way that startMerges picks them.
+        while(groupRunSizes.count() >= 2)
+        {
+            int leftSize = groupRunSizes.takeAt(std::min_element(groupRunSizes.begin(), groupRunSizes.end()) - groupRunSizes.begin());
+            int rightSize = groupRunSizes.takeAt(std::min_element(groupRunSizes.begin(), groupRunSizes.end()) - groupRunSizes.begin());
+            int lowerBound = 0;
+            int upperBound = 0;
+            getMergeBounds(leftSize, rightSize, &lowerBound, &upperBound);
+            mFutureLowerBounds.append(lowerBound);
+            mFutureUpperBounds.append(upperBound);
+            groupRunSizes.append(leftSize + rightSize);
+        }
+    }
+
+    // Turn the bounds of each task into the sum of the bounds from that task on.
+    mFutureLowerBounds.append(0);
+    mFutureUpperBounds.append(0);
+    for(int i = mFutureLowerBounds.count() - 2; i >= 0; i--)
+    {
+        mFutureLowerBounds[i] += mFutureLowerBounds[i + 1];
+        mFutureUpperBounds[i] += mFutureUpperBounds[i + 1];
+    }
+}
+
+/**
+ * @brief Plays out the merges of a sort whose tasks finish in order, adding the bounds of each merge to the future bounds.
+ * @param aTaskSizes The number of items in each task that hasn't finished, in the order that the tasks finish.
+ * @param aRunSizes The sizes of the runs that are waiting for a merge partner.
+ * @return The size of the run that is left once every merge has finished, or 0 if there are no items.
+ */
+int RankingEngine::planMerges(QList<int> aTaskSizes, QList<int> aRunSizes)
+{
+    for(int i = 0; i < aTaskSizes.count(); i++)
+    {
+        aRunSizes.append(aTaskSizes[i]);
+        while(aRunSizes.count() >= 2)
+        {
+            int leftSize = aRunSizes.takeFirst();
+            int rightSize = aRunSizes.takeFirst();
+            int lowerBound = 0;
+            int upperBound = 0;
+            getMergeBounds(leftSize, rightSize, &lowerBound, &upperBound);
+            mFutureLowerBounds.append(lowerBound);
+            mFutureUpperBounds.append(upperBound);
+            aTaskSizes.append(leftSize + rightSize);
+        }
+    }
+    return aRunSizes.isEmpty() ? 0 : aRunSizes.first();
+}
+
+/**
+ * @brief Pairs up the pending runs into merge tasks, and moves on to the next group once a group is sorted.
+ * @param aDelta Where the changes are recorded, so that they can be undone.
+ *
+ * Runs are merged in the order that they were finished, which keeps the merges balanced. In a hierarchical sort
+ * the pending runs all belong to the group being sorted. Once it's down to a single run with nothing left to do,
+ * the run joins the group runs and the next group is chunked. After the last group, the two smallest group runs
+ * are merged, one merge at a time so that the run each merge produces can be picked for the next one.
+ */
+void RankingEngine::startMerges(decision_delta* aDelta)
+{
+    while(true)
+    {
+        if(mPendingRuns.count() >= 2)
+        {
+            sort_task task;
+            task.id = mNextTaskId++;
+            task.left = mPendingRuns.takeFirst();
+            task.right = mPendingRuns.takeFirst();
+            mActiveTasks.append(task);
+            addTaskBounds(task, 1);
+            aDelta->num_started_merges++;
+        }
+        else if(!mIsHierarchical || !mActiveTasks.isEmpty())
+        {
+            return;
+        }
+        else if(mPendingRuns.count() == 1)
+        {
+            mGroupRuns.append(mPendingRuns.takeFirst());
+            aDelta->num_finished_groups++;
+        }
+        else if(!mWaitingGroups.isEmpty())
+        {
+            addChunks(mWaitingGroups.takeFirst());
+            aDelta->num_started_groups++;
+        }
+        else
+        {
+            if(mGroupRuns.count() >= 2)
+            {
+                sort_task task;
+                task.id = mNextTaskId++;
+                aDelta->group_merge_left_pos = findSmallestGroupRun();
+                task.left = mGroupRuns.takeAt(aDelta->group_merge_left_pos);
+                aDelta->group_merge_right_pos = findSmallestGroupRun();
+                task.right = mGroupRuns.takeAt(aDelta->group_merge_right_pos);
+                mActiveTasks.append(task);
+                addTaskBounds(task, 1);
+            }
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Undoes the most recent decision using its @link RankingEngine::decision_delta delta@endlink.
+ *
+ * Decisions are undone in the opposite order that they were made, so the engine is in exactly the state
+ * that the decision left it in. This means that merges started by the decision haven't made any progress
+ * and can just be taken apart again.
+ */
+void RankingEngine::undoDecision()
+{
+    decision_delta delta = mJournal.takeLast();
+    mNumInteractions--;
+
+    if(delta.finished_task)
+    {
+        // Put the runs of a merge between groups back where they were in the group runs.
+        if(delta.group_merge_left_pos >= 0)
+        {
+            sort_task merge = mActiveTasks.takeLast();
+            addTaskBounds(merge, -1);
+            mGroupRuns.insert(delta.group_merge_right_pos, merge.right);
+            mGroupRuns.insert(delta.group_merge_left_pos, merge.left);
+            mNextTaskId--;
+        }
+
+        // Groups are finished and started in turn, starting with a finished one, so take them back in the opposite order.
+        int numFinishedGroups = delta.num_finished_groups;
+        int numStartedGroups = delta.num_started_groups;
+        while(numFinishedGroups > 0)
+        {
+            if(numStartedGroups == numFinishedGroups)
+            {
+                undoGroupStart();
+                numStartedGroups--;
+            }
+            else
+            {
+                mPendingRuns.append(mGroupRuns.takeLast());
+                numFinishedGroups--;
+            }
+        }
+
+        // Put the runs of the merges that were started back at the front of the pending runs, in their original order.
+        for(int i = 0; i < delta.num_started_merges; i++)
+        {
+            sort_task merge = mActiveTasks.takeLast();
+            addTaskBounds(merge, -1);
+            mPendingRuns.prepend(merge.right);
+            mPendingRuns.prepend(merge.left);
+            mNextTaskId--;
+        }
+
+        // The run that the task produced is the last pending run again, so replace it with the task.
+        mPendingRuns.removeLast();
+        mActiveTasks.insert(delta.task_index, delta.task);
+
+        // Let go of the delta's copy so that the task's output isn't shared when it's truncated below.
+        delta.task = sort_task();
+    }
+    else
+    {
+        addTaskBounds(mActiveTasks[delta.task_index], -1);
+    }
+
+    sort_task& task = mActiveTasks[delta.task_index];
+    if(delta.inserted_pos >= 0)
+    {
+        task.right.prepend(task.left.takeAt(delta.inserted_pos));
+    }
+    task.left_pos = delta.left_pos;
+    task.right_pos = delta.right_pos;
+    task.output.resize(delta.output_size);
+    addTaskBounds(task, 1);
+}
+
+/**
+ * @brief Takes back the start of a group's sort, putting the group back at the front of the waiting groups.
+ *
+ * This is only done while undoing the decision that started the group, so the group's chunk tasks and single item
+ * run are the only active tasks and pending run, and none of them have made any progress.
+ */
+void RankingEngine::undoGroupStart()
+{
+    QVector<int> group;
+    for(const sort_task& task : mActiveTasks)
+    {
+        addTaskBounds(task, -1);
+        group += task.left;
+    }
+    for(const QVector<int>& run : mPendingRuns)
+    {
+        group += run;
+    }
+    mNextTaskId -= mActiveTasks.count();
+    mActiveTasks.clear();
+    mPendingRuns.clear();
+    mWaitingGroups.prepend(group);
+}
@@ -0,0 +1,125 @@
+#ifndef RANKINGENGINE_H
+#define RANKINGENGINE_H
+
+#include <algorithm>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QVector>
+
+#define PAIRWISE_BATCH_SIZE 2
+#define MAX_BATCH_SIZE 6
+
+class RankingEngine
+{
+    public:
+        /**
+         * @brief A group of items that the user fully orders in a single interaction.
+         */
+        typedef struct comparison_group
+        {
+            int task_id = -1; //!< The id of the sort task that the group belongs to.
+            QVector<int> items; //!< The items that should be ordered, in the order they should be presented.
+        } comparison_group;
+
+        explicit RankingEngine(int aNumItems = 0, int aBatchSize = PAIRWISE_BATCH_SIZE);
+        ~RankingEngine();
+
+        bool canUndo() const;
+        int getBatchSize() const;
+        QList<comparison_group> getFrontier() const;
+        comparison_group getNextGroup() const;
+        int getNumInteractions() const;
+        QList<QVector<int>> getPartialOrder() const;
+        QVector<int> getUpcomingItems() const;
+        QVector<int> getRanking() const;
+        void getRemainingInteractions(int* aLowerBound, int* aUpperBound) const;
+        bool isFinished() const;
+        bool isHierarchical() const;
+        comparison_group predictNextGroup(int aTaskId, const QVector<int>& aOrderedItems);
+        void reset(int aNumItems, int aBatchSize);
+        void resetWithGroups(const QList<QVector<int>>& aGroups, int aNumItems, int aBatchSize);
+        void resetWithRanking(const QVector<int>& aRanking, int aNumItems, int aBatchSize);
+        bool submitOrdering(int aTaskId, const QVector<int>& aOrderedItems);
+        int undo(int aNumDecisions = 1);
+
+    private:
+        /**
+         * @brief An independent unit of sorting work.
+         *
+         * A chunk task fully orders a small group of unsorted items in one interaction. A merge task
+         * merges two sorted runs, consuming a window from the head of each run per interaction. An insertion
+         * task searches for the place of each new item in a ranked run, one item at a time.
+         */
+        typedef struct sort_task
+        {
+            int id = -1; //!< The id of the task.
+            bool is_chunk = false; //!< True if the task orders an unsorted chunk instead of merging two runs.
+            bool is_insertion = false; //!< True if the task inserts new items into a ranked run instead of merging two runs.
+            QVector<int> left; //!< The first sorted run, the unsorted items of a chunk task, or the ranked run of an insertion task.
+            QVector<int> right; //!< The second sorted run, or the items that an insertion task still has to insert. Empty for chunk tasks.
+            int left_pos = 0; //!< The index of the next unmerged item in the left run. For insertion tasks, the first position that the current item can still be inserted at.
+            int right_pos = 0; //!< The index of the next unmerged item in the right run. For insertion tasks, the last position that the current item can still be inserted at.
+            QVector<int> output; //!< The merged items so far, best first.
+        } sort_task;
+
+        /**
+         * @brief What a single decision changed, so that it can be undone.
+         *
+         * Only the positions of the task before the decision are kept. If the decision finished the task, the
+         * finished task is kept as well. Its vectors are implicitly shared with the run it produced, so keeping
+         * it doesn't copy anything.
+         */
+        typedef struct decision_delta
+        {
+            int task_index = -1; //!< The index of the task in the active task list when the decision was made.
+            int left_pos = 0; //!< The left position of the task before the decision.
+            int right_pos = 0; //!< The right position of the task before the decision.
+            int output_size = 0; //!< The size of the task's output before the decision.
+            int num_started_merges = 0; //!< The number of merge tasks that were started because the task finished.
+            int num_finished_groups = 0; //!< The number of groups whose sorts were finished, moving their runs to the group runs.
+            int num_started_groups = 0; //!< The number of waiting groups whose sorts were started because a group finished.
+            int group_merge_left_pos = -1; //!< Where the left run of the group merge that was started was in the group runs. -1 if none was started.
+            int group_merge_right_pos = -1; //!< Where the right run of the group merge was in the group runs, once the left run was taken out.
+            bool finished_task = false; //!< True if the decision finished the task.
+            int inserted_pos = -1; //!< Where the decision inserted an item into the ranked run of an insertion task. -1 if it didn't insert one.
+            sort_task task; //!< The finished task. Only set if the decision finished the task.
+        } decision_delta;
+
+        void addChunks(const QVector<int>& aItems);
+        void addTaskBounds(const sort_task& aTask, int aSign);
+        comparison_group buildGroup(const sort_task& aTask) const;
+        void finishTask(int aTaskIndex, decision_delta* aDelta);
+        int findSmallestGroupRun() const;
+        void getMergeBounds(int aLeftSize, int aRightSize, int* aLowerBound, int* aUpperBound) const;
+        QVector<int> getPivotPositions(const sort_task& aTask) const;
+        void getSearchBounds(int aRangeSize, int* aLowerBound, int* aUpperBound) const;
+        void getTaskBounds(const sort_task& aTask, int* aLowerBound, int* aUpperBound) const;
+        int getWindowSize(bool aLeftRun) const;
+        void planFutureTasks();
+        int planMerges(QList<int> aTaskSizes, QList<int> aRunSizes);
+        void startMerges(decision_delta* aDelta);
+        void undoDecision();
+        void undoGroupStart();
+
+        int mActiveLowerBound = 0; //!< The fewest interactions that the active tasks can still take, summed over the tasks.
+        int mActiveUpperBound = 0; //!< The most interactions that the active tasks can still take, summed over the tasks.
+        int mBatchSize = PAIRWISE_BATCH_SIZE; //!< The maximum number of items in a comparison group.
+        QVector<int> mFutureLowerBounds; //!< For each task id, the fewest interactions that the tasks with that id and later ids take once they're started.
+        QVector<int> mFutureUpperBounds; //!< For each task id, the most interactions that the tasks with that id and later ids take once they're started.
+        QList<QVector<int>> mGroupRuns; //!< The sorted runs of the groups that have been finished, and of the merges between them.
+        QVector<int> mInsertionLowerBounds; //!< For each number of inserted items, the fewest interactions that inserting the items after the next one takes.
+        QVector<int> mInsertionUpperBounds; //!< For each number of inserted items, the most interactions that inserting the items after the next one takes.
+        bool mIsHierarchical = false; //!< True if the items are sorted within their groups before the groups are merged.
+        int mNextTaskId = 0; //!< The id that will be given to the next task.
+        int mNumInitiallyRanked = 0; //!< The number of items that were ranked before an insertion sort started.
+        int mNumInteractions = 0; //!< The number of orderings that have been submitted.
+        int mNumItems = 0; //!< The number of items being ranked.
+        QList<sort_task> mActiveTasks; //!< The tasks that are waiting on the user. These make up the frontier.
+        QVector<decision_delta> mJournal; //!< What each decision changed, in the order that the decisions were made.
+        QList<QVector<int>> mPendingRuns; //!< Sorted runs that are waiting for a merge partner.
+        mutable QHash<int, QPair<int, int>> mSearchBounds; //!< The fewest and most interactions that finding the place of an item among a number of ranked items takes.
+        QList<QVector<int>> mWaitingGroups; //!< The groups whose sorts haven't been started yet, in the order they'll be started.
+};
+
+#endif // RANKINGENGINE_H
@@ -0,0 +1,20 @@
+#-------------------------------------------------
+#
+# Performance tests for the import and song list hot paths.
+# Run them with "make check", or run the test binary with
+# -platform offscreen on machines without a display.
+#
+#-------------------------------------------------
+
+QT       += core gui widgets multimedia testlib
+CONFIG += c++14 testcase
+
+TARGET = tst_performance
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    performancetests.cpp
+
+include(../../SongSorter.pri)
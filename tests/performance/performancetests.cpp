@@ -0,0 +1,327 @@
+#include <cstring>
+#include <QCheckBox>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QLayout>
+#include <QStandardPaths>
+#include <QTableView>
+#include <QTableWidget>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <taglib/fileref.h>
+#include <taglib/tag.h>
+#include "songHandling/directorytraverser.h"
+#include "songHandling/songbatch.h"
+#include "songHandling/tagworkerpool.h"
+#include "UI/songlistviewerwindow.h"
+#include "UI/startupwindow.h"
+
+#define NUM_FIXTURE_FILES 500
+#define NUM_FIXTURE_FRAMES 8
+#define NUM_RESULT_SONGS 20000
+#define NUM_EDITED_SONGS 5000
+#define NUM_TEARDOWN_SONGS 100000
+#define NUM_RESORTED_SONGS 100000
+
+#define MAX_IMPORT_MS 5000
+#define MAX_FILL_RESULTS_MS 3000
+#define MAX_FILL_EDITABLE_MS 5000
+#define MAX_REMOVE_SONGS_MS 1000
+#define MAX_RESORT_RESULTS_MS 1000
+#define MAX_TEARDOWN_MS 1000
+
+/**
+  @class PerformanceTests
+  @brief Benchmarks the hot paths of importing songs and showing song lists.
+
+  Each test runs its code in a QBENCHMARK block and fails if the time per run goes over a limit. The limits
+  are several times what the code takes today, so they only catch big regressions, such as an operation
+  that becomes quadratic in the number of songs.
+
+  Folder imports are run against fixture MP3 files that are generated when the tests start. The other tests
+  use synthetic song lists.
+*/
+class PerformanceTests : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void initTestCase();
+        void benchmarkFolderImport();
+        void benchmarkFillResultsTable();
+        void benchmarkFillEditableTable();
+        void benchmarkRemoveManySongs();
+        void benchmarkResortResults();
+        void benchmarkStartupWindowTeardown();
+
+    private:
+        static bool writeFixtureFile(const QString& aFilePath, int aIndex);
+        static QList<Song*> createSyntheticSongs(SongBatch* aBatch, int aNumSongs);
+
+        QTemporaryDir mFixtureDirectory; //!< The folder that the fixture song files are generated in.
+};
+
+//-----------------------------------------------
+// Slots
+//-----------------------------------------------
+
+/**
+ * @brief Generates the fixture song files.
+ *
+ * The files are spread over nested folders, like a real library, and each one gets its own tags.
+ */
+void PerformanceTests::initTestCase()
+{
+    // Keep the application's caches out of the user's directories.
+    QStandardPaths::setTestModeEnabled(true);
+
+    QVERIFY(mFixtureDirectory.isValid());
+    for(int i = 0; i < NUM_FIXTURE_FILES; i++)
+    {
+        QString folder = QString("%1/Artist %2/Album %3").arg(mFixtureDirectory.path()).arg(i % 20).arg(i % 50);
+        QVERIFY(QDir().mkpath(folder));
+        QVERIFY(writeFixtureFile(QString("%1/%2.mp3").arg(folder).arg(i), i));
+    }
+}
+
+/**
+ * @brief Benchmarks finding and reading the tags of the songs in a folder.
+ *
+ * The tags are read through a TagWorkerPool, like the app does, so the helper processes are part of what's timed.
+ */
+void PerformanceTests::benchmarkFolderImport()
+{
+    TagWorkerPool tagWorkerPool;
+    int numIterations = 0;
+    int numSongs = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK
+    {
+        SongBatch batch;
+        DirectoryTraverser traverser;
+        QVector<IoScheduler::file_location> locations;
+        QStringList songFiles = traverser.findSongFiles(mFixtureDirectory.path(), &locations);
+        numSongs = tagWorkerPool.readSongs(songFiles, &batch, locations).count();
+        numIterations++;
+    }
+    qint64 msPerIteration = timer.elapsed() / numIterations;
+
+    QCOMPARE(numSongs, NUM_FIXTURE_FILES);
+    QVERIFY2(msPerIteration < MAX_IMPORT_MS, qPrintable(QString("Importing took %1 ms").arg(msPerIteration)));
+}
+
+/**
+ * @brief Benchmarks filling the table with a large list of results.
+ */
+void PerformanceTests::benchmarkFillResultsTable()
+{
+    SongBatch batch;
+    QList<Song*> songs = createSyntheticSongs(&batch, NUM_RESULT_SONGS);
+    for(int i = 0; i < songs.count(); i++)
+    {
+        songs[i]->setRank(i + 1);
+    }
+    SongListViewerWindow window;
+
+    int numIterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK
+    {
+        window.setupSongListViewerWindow(SongListViewerWindow::SHOW_RESULTS, &songs);
+        numIterations++;
+    }
+    qint64 msPerIteration = timer.elapsed() / numIterations;
+
+    QCOMPARE(window.findChild<QTableView*>("resultsTableView")->model()->rowCount(), NUM_RESULT_SONGS);
+    QVERIFY2(msPerIteration < MAX_FILL_RESULTS_MS, qPrintable(QString("Filling the table took %1 ms").arg(msPerIteration)));
+}
+
+/**
+ * @brief Benchmarks filling the table with songs that can be edited, which need a widget for each checkbox and track number.
+ */
+void PerformanceTests::benchmarkFillEditableTable()
+{
+    SongBatch batch;
+    QList<Song*> songs = createSyntheticSongs(&batch, NUM_EDITED_SONGS);
+    SongListViewerWindow window;
+
+    int numIterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK
+    {
+        window.setupSongListViewerWindow(SongListViewerWindow::EDIT_MAIN_SONG_LIST, &songs);
+        numIterations++;
+    }
+    qint64 msPerIteration = timer.elapsed() / numIterations;
+
+    QCOMPARE(window.findChild<QTableWidget*>("songListTableWidget")->rowCount(), NUM_EDITED_SONGS);
+    QVERIFY2(msPerIteration < MAX_FILL_EDITABLE_MS, qPrintable(QString("Filling the table took %1 ms").arg(msPerIteration)));
+}
+
+/**
+ * @brief Benchmarks saving a song list after most of its songs were unchecked.
+ */
+void PerformanceTests::benchmarkRemoveManySongs()
+{
+    SongBatch batch;
+    QList<Song*> songs = createSyntheticSongs(&batch, NUM_EDITED_SONGS);
+    SongListViewerWindow window;
+    window.setupSongListViewerWindow(SongListViewerWindow::CONFIRM_IMPORTED_SONGS, &songs);
+
+    // Uncheck every song except every tenth one.
+    QTableWidget* table = window.findChild<QTableWidget*>("songListTableWidget");
+    for(int row = 0; row < table->rowCount(); row++)
+    {
+        if(row % 10 != 0)
+        {
+            table->cellWidget(row, CHECKBOX_OR_RANK_COLUMN)->findChild<QCheckBox*>()->setChecked(false);
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK_ONCE
+    {
+        QMetaObject::invokeMethod(&window, "on_buttonBox_accepted");
+    }
+    qint64 msElapsed = timer.elapsed();
+
+    QCOMPARE(songs.count(), NUM_EDITED_SONGS / 10);
+    QVERIFY2(msElapsed < MAX_REMOVE_SONGS_MS, qPrintable(QString("Removing songs took %1 ms").arg(msElapsed)));
+}
+
+/**
+ * @brief Benchmarks sorting a large list of results by a column, the way clicking its header does.
+ */
+void PerformanceTests::benchmarkResortResults()
+{
+    SongBatch batch;
+    QList<Song*> songs = createSyntheticSongs(&batch, NUM_RESORTED_SONGS);
+    for(int i = 0; i < songs.count(); i++)
+    {
+        songs[i]->setRank(i + 1);
+    }
+    SongListViewerWindow window;
+    window.setupSongListViewerWindow(SongListViewerWindow::SHOW_RESULTS, &songs);
+    QAbstractItemModel* model = window.findChild<QTableView*>("resultsTableView")->model();
+
+    // Each click alternates between the artist and song name columns, so every run really re-sorts.
+    int numIterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK
+    {
+        QMetaObject::invokeMethod(&window, "on_tableHeaderClicked", Q_ARG(int, (numIterations % 2 == 0) ? ARTIST_COLUMN : SONG_NAME_COLUMN));
+        numIterations++;
+    }
+    qint64 msPerIteration = timer.elapsed() / numIterations;
+
+    QCOMPARE(model->rowCount(), NUM_RESORTED_SONGS);
+    QVERIFY2(msPerIteration < MAX_RESORT_RESULTS_MS, qPrintable(QString("Re-sorting the results took %1 ms").arg(msPerIteration)));
+}
+
+/**
+ * @brief Benchmarks destroying the StartupWindow while it holds a large library.
+ */
+void PerformanceTests::benchmarkStartupWindowTeardown()
+{
+    StartupWindow* window = new StartupWindow();
+    window->mSongs = createSyntheticSongs(&window->mLibraryBatch, NUM_TEARDOWN_SONGS);
+
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK_ONCE
+    {
+        delete window;
+    }
+    qint64 msElapsed = timer.elapsed();
+
+    QVERIFY2(msElapsed < MAX_TEARDOWN_MS, qPrintable(QString("Teardown took %1 ms").arg(msElapsed)));
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Writes a small MP3 file with tags.
+ * @param aFilePath The path of the file.
+ * @param aIndex The number of the fixture. The tags are based on it.
+ * @return True if the file was written and tagged.
+ *
+ * The audio is a few silent MPEG-1 Layer III frames, which is enough for TagLib to accept the file.
+ */
+bool PerformanceTests::writeFixtureFile(const QString& aFilePath, int aIndex)
+{
+    // 128 kbps at 44.1 kHz without padding gives 417 byte frames.
+    QByteArray frame(417, '\0');
+    frame[0] = (char)0xFF;
+    frame[1] = (char)0xFB;
+    frame[2] = (char)0x90;
+    frame[3] = (char)0x00;
+
+    QFile file(aFilePath);
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        return false;
+    }
+    for(int i = 0; i < NUM_FIXTURE_FRAMES; i++)
+    {
+        file.write(frame);
+    }
+    file.close();
+
+    TagLib::FileRef fileRef(QFile::encodeName(aFilePath).constData());
+    if(fileRef.isNull() || fileRef.tag() == nullptr)
+    {
+        return false;
+    }
+    fileRef.tag()->setArtist(TagLib::String(QString("Artist %1").arg(aIndex % 20).toUtf8().constData(), TagLib::String::UTF8));
+    fileRef.tag()->setAlbum(TagLib::String(QString("Album %1").arg(aIndex % 50).toUtf8().constData(), TagLib::String::UTF8));
+    fileRef.tag()->setTitle(TagLib::String(QString("Song %1").arg(aIndex).toUtf8().constData(), TagLib::String::UTF8));
+    fileRef.tag()->setTrack(aIndex % 12 + 1);
+    return fileRef.save();
+}
+
+/**
+ * @brief Creates songs with made-up tags.
+ * @param aBatch The batch that the songs are created in.
+ * @param aNumSongs The number of songs to create.
+ * @return The songs.
+ */
+QList<Song*> PerformanceTests::createSyntheticSongs(SongBatch* aBatch, int aNumSongs)
+{
+    QList<Song*> songs;
+    songs.reserve(aNumSongs);
+    for(int i = 0; i < aNumSongs; i++)
+    {
+        songs.append(aBatch->createSong(i % 12 + 1, QString("Album %1").arg(i % 1000), QString("Artist %1").arg(i % 200),
+                                        QString("C:/Music/%1.mp3").arg(i), QString("Song %1").arg(i)));
+    }
+    return songs;
+}
+
+/**
+ * @brief Runs the tests.
+ *
+ * This replaces QTEST_MAIN, because the TagWorkerPool starts the running executable as its helper processes.
+ * The test binary has to act as a helper when it's started that way, just like the app.
+ */
+int main(int argc, char *argv[])
+{
+    if(argc > 1 && std::strcmp(argv[1], TAG_WORKER_ARGUMENT) == 0)
+    {
+        return TagWorkerPool::runWorker();
+    }
+
+    QApplication app(argc, argv);
+    app.setAttribute(Qt::AA_Use96Dpi, true);
+    PerformanceTests tests;
+    QTEST_SET_MAIN_SOURCE_PATH
+    return QTest::qExec(&tests, argc, argv);
+}
+
+#include "performancetests.moc"
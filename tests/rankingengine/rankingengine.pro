@@ -0,0 +1,24 @@
+#-------------------------------------------------
+#
+# Unit tests for the RankingEngine. The engine only needs
+# QtCore, so these run without a display or TagLib.
+#
+#-------------------------------------------------
+
+QT       -= gui
+QT       += core testlib
+CONFIG += c++14 testcase console
+
+TARGET = tst_rankingengine
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += $$PWD/../..
+
+SOURCES += \
+    rankingenginetests.cpp \
+    $$PWD/../../sorting/rankingengine.cpp
+
+HEADERS += \
+    $$PWD/../../sorting/rankingengine.h
@@ -0,0 +1,432 @@
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <QString>
+#include <QStringList>
+#include <QSet>
+#include <QtTest>
+#include "sorting/rankingengine.h"
+
+#define SCORE_SEED 20180518
+#define REUSE_INTERVAL 3
+#define UNDO_INTERVAL 5
+
+/**
+  @class RankingEngineTests
+  @brief Unit tests for the RankingEngine.
+
+  Each test plays whole sorts against a scripted user. The user orders every group by a fixed, shuffled score
+  that the engine can't see, so the final ranking is known in advance. The sorts cover sorting from scratch,
+  inserting new items into a ranking and sorting within groups, both in pairs and in larger batches.
+*/
+class RankingEngineTests : public QObject
+{
+    Q_OBJECT
+
+    private slots:
+        void undoRestoresPriorState_data();
+        void undoRestoresPriorState();
+        void insertionTakesLogarithmicInteractions_data();
+        void insertionTakesLogarithmicInteractions();
+        void remainingInteractionsAreBounded_data();
+        void remainingInteractionsAreBounded();
+        void groupedSortStaysWithinGroups_data();
+        void groupedSortStaysWithinGroups();
+
+    private:
+        static void addSortRows();
+        static QString describeItems(const QVector<int>& aItems);
+        static QString describeState(const RankingEngine& aEngine);
+        static int getGroup(int aItem, int aNumGroups);
+        static QVector<int> getScores(int aNumItems);
+        static QVector<int> orderItems(const QVector<int>& aItems, const QVector<int>& aScores);
+        static void startSort(RankingEngine* aEngine, const QVector<int>& aScores, int aNumRanked, int aNumGroups, int aBatchSize);
+};
+
+//-----------------------------------------------
+// Slots
+//-----------------------------------------------
+
+/**
+ * @brief Adds the sorts that the undo test plays.
+ */
+void RankingEngineTests::undoRestoresPriorState_data()
+{
+    addSortRows();
+}
+
+/**
+ * @brief Checks that undoing decisions puts the engine back in exactly the state it was in before them.
+ *
+ * Some decisions are marked as reused from earlier sorts. Like the ComparisonWindow's undo button, each undo
+ * takes back the last decision that the user made along with the reused decisions after it. Predicting the
+ * next group tries a decision out and takes it back through the same journal, so it's checked to leave no trace.
+ */
+void RankingEngineTests::undoRestoresPriorState()
+{
+    QFETCH(int, numItems);
+    QFETCH(int, numRanked);
+    QFETCH(int, numGroups);
+    QFETCH(int, batchSize);
+
+    QVector<int> scores = getScores(numItems);
+    RankingEngine engine;
+    startSort(&engine, scores, numRanked, numGroups, batchSize);
+
+    // The state after each number of decisions, and whether each decision was reused instead of made by the user.
+    QStringList states;
+    states.append(describeState(engine));
+    QVector<bool> reusedDecisions;
+    int lastUndoneCount = 0;
+    while(!engine.isFinished())
+    {
+        RankingEngine::comparison_group group = engine.getNextGroup();
+        QVector<int> orderedItems = orderItems(group.items, scores);
+        engine.predictNextGroup(group.task_id, orderedItems);
+        QCOMPARE(describeState(engine), states.last());
+
+        QVERIFY(engine.submitOrdering(group.task_id, orderedItems));
+        reusedDecisions.append(reusedDecisions.count() % REUSE_INTERVAL == REUSE_INTERVAL - 1);
+        states.append(describeState(engine));
+
+        // Every few decisions, undo back to before the last decision that the user made. Each point is only
+        // undone once, since the same decisions are made again afterwards.
+        int lastUserDecision = reusedDecisions.lastIndexOf(false);
+        if(reusedDecisions.count() % UNDO_INTERVAL == 0 && reusedDecisions.count() > lastUndoneCount && lastUserDecision >= 0)
+        {
+            lastUndoneCount = reusedDecisions.count();
+            int numDecisions = reusedDecisions.count() - lastUserDecision;
+            QCOMPARE(engine.undo(numDecisions), numDecisions);
+            reusedDecisions.resize(lastUserDecision);
+            states = states.mid(0, lastUserDecision + 1);
+            QCOMPARE(describeState(engine), states.last());
+        }
+    }
+
+    QVector<int> items(numItems);
+    std::iota(items.begin(), items.end(), 0);
+    QCOMPARE(engine.getRanking(), orderItems(items, scores));
+
+    // Undoing every decision goes back to the start of the sort.
+    QCOMPARE(engine.undo(engine.getNumInteractions()), states.count() - 1);
+    QCOMPARE(describeState(engine), states.first());
+    QVERIFY(!engine.canUndo());
+}
+
+/**
+ * @brief Adds the rankings that new items are inserted into.
+ */
+void RankingEngineTests::insertionTakesLogarithmicInteractions_data()
+{
+    QTest::addColumn<int>("numRanked");
+    QTest::addColumn<int>("numNew");
+    QTest::addColumn<int>("batchSize");
+
+    QTest::newRow("album into 3000 songs in pairs") << 3000 << 12 << 2;
+    QTest::newRow("album into 3000 songs in batches of 4") << 3000 << 12 << 4;
+    QTest::newRow("album into 100 songs in pairs") << 100 << 12 << 2;
+    QTest::newRow("one song into 1000 songs in pairs") << 1000 << 1 << 2;
+}
+
+/**
+ * @brief Checks that new items are inserted into a finished ranking with a search, instead of sorting everything again.
+ *
+ * Each interaction shows one new item with pivots from the ranking, which split the positions that it can still go in.
+ * In pairs that is a binary search, and larger batches split the positions into more parts, so each item takes at most
+ * as many interactions as halving its positions down to one, which is about log2(n).
+ */
+void RankingEngineTests::insertionTakesLogarithmicInteractions()
+{
+    QFETCH(int, numRanked);
+    QFETCH(int, numNew);
+    QFETCH(int, batchSize);
+
+    QVector<int> scores = getScores(numRanked + numNew);
+    RankingEngine engine;
+    QVector<int> rankedItems(numRanked);
+    std::iota(rankedItems.begin(), rankedItems.end(), 0);
+    engine.resetWithRanking(orderItems(rankedItems, scores), scores.count(), batchSize);
+
+    int maxInteractions = 0;
+    for(int i = 0; i < numNew; i++)
+    {
+        int numPositions = numRanked + i + 1;
+        while(numPositions > 1)
+        {
+            numPositions = (numPositions + 1) / 2;
+            maxInteractions++;
+        }
+    }
+
+    while(!engine.isFinished())
+    {
+        RankingEngine::comparison_group group = engine.getNextGroup();
+        QVERIFY(group.items.first() >= numRanked);
+        QVERIFY(group.items.count() <= batchSize);
+        QVERIFY(engine.submitOrdering(group.task_id, orderItems(group.items, scores)));
+    }
+
+    QVector<int> items(scores.count());
+    std::iota(items.begin(), items.end(), 0);
+    QCOMPARE(engine.getRanking(), orderItems(items, scores));
+    QVERIFY2(engine.getNumInteractions() <= maxInteractions,
+             qPrintable(QString("Inserting took %1 interactions, but a binary search takes at most %2").arg(engine.getNumInteractions()).arg(maxInteractions)));
+}
+
+/**
+ * @brief Adds the sorts that the bounds are checked on.
+ */
+void RankingEngineTests::remainingInteractionsAreBounded_data()
+{
+    addSortRows();
+}
+
+/**
+ * @brief Checks that the bounds on the remaining interactions hold at every step of a sort.
+ *
+ * The bounds at each step are kept, and once the sort is finished they're compared with the number of
+ * interactions that were actually left at that step.
+ */
+void RankingEngineTests::remainingInteractionsAreBounded()
+{
+    QFETCH(int, numItems);
+    QFETCH(int, numRanked);
+    QFETCH(int, numGroups);
+    QFETCH(int, batchSize);
+
+    QVector<int> scores = getScores(numItems);
+    RankingEngine engine;
+    startSort(&engine, scores, numRanked, numGroups, batchSize);
+
+    QVector<int> lowerBounds;
+    QVector<int> upperBounds;
+    while(true)
+    {
+        int lowerBound = 0;
+        int upperBound = 0;
+        engine.getRemainingInteractions(&lowerBound, &upperBound);
+        QVERIFY(lowerBound <= upperBound);
+        lowerBounds.append(lowerBound);
+        upperBounds.append(upperBound);
+        if(engine.isFinished())
+        {
+            break;
+        }
+
+        RankingEngine::comparison_group group = engine.getNextGroup();
+        QVERIFY(engine.submitOrdering(group.task_id, orderItems(group.items, scores)));
+    }
+
+    int numInteractions = engine.getNumInteractions();
+    QCOMPARE(lowerBounds.count(), numInteractions + 1);
+    for(int i = 0; i <= numInteractions; i++)
+    {
+        int numRemaining = numInteractions - i;
+        QVERIFY2(lowerBounds[i] <= numRemaining && numRemaining <= upperBounds[i],
+                 qPrintable(QString("After %1 interactions, %2 were left, but the bounds were %3 to %4")
+                            .arg(i).arg(numRemaining).arg(lowerBounds[i]).arg(upperBounds[i])));
+    }
+}
+
+/**
+ * @brief Adds the groups that are sorted.
+ */
+void RankingEngineTests::groupedSortStaysWithinGroups_data()
+{
+    QTest::addColumn<int>("numItems");
+    QTest::addColumn<int>("numGroups");
+    QTest::addColumn<int>("batchSize");
+
+    QTest::newRow("3 albums in pairs") << 24 << 3 << 2;
+    QTest::newRow("7 albums in batches of 3") << 100 << 7 << 3;
+    QTest::newRow("7 albums in batches of 6") << 100 << 7 << MAX_BATCH_SIZE;
+}
+
+/**
+ * @brief Checks that a grouped sort starts within a group and finishes each group's sort before it moves on to another.
+ *
+ * Merges between groups can be shown in between, but once the sort has moved on from a group, no more groups
+ * with only that group's items are shown.
+ */
+void RankingEngineTests::groupedSortStaysWithinGroups()
+{
+    QFETCH(int, numItems);
+    QFETCH(int, numGroups);
+    QFETCH(int, batchSize);
+
+    QVector<int> scores = getScores(numItems);
+    RankingEngine engine;
+    startSort(&engine, scores, 0, numGroups, batchSize);
+    QVERIFY(engine.isHierarchical());
+
+    int currentGroup = -1;
+    QSet<int> finishedGroups;
+    while(!engine.isFinished())
+    {
+        RankingEngine::comparison_group group = engine.getNextGroup();
+        bool isWithinGroup = true;
+        for(int item : group.items)
+        {
+            isWithinGroup = isWithinGroup && (getGroup(item, numGroups) == getGroup(group.items.first(), numGroups));
+        }
+        QVERIFY(isWithinGroup || currentGroup >= 0);
+
+        if(isWithinGroup && getGroup(group.items.first(), numGroups) != currentGroup)
+        {
+            QVERIFY(!finishedGroups.contains(getGroup(group.items.first(), numGroups)));
+            finishedGroups.insert(currentGroup);
+            currentGroup = getGroup(group.items.first(), numGroups);
+        }
+        QVERIFY(engine.submitOrdering(group.task_id, orderItems(group.items, scores)));
+    }
+
+    QVector<int> items(numItems);
+    std::iota(items.begin(), items.end(), 0);
+    QCOMPARE(engine.getRanking(), orderItems(items, scores));
+}
+
+//-----------------------------------------------
+// Private Functions
+//-----------------------------------------------
+
+/**
+ * @brief Adds a test row for each kind of sort.
+ *
+ * Each row has the number of items, how many of them are already ranked, how many groups they're sorted in
+ * and the batch size.
+ */
+void RankingEngineTests::addSortRows()
+{
+    QTest::addColumn<int>("numItems");
+    QTest::addColumn<int>("numRanked");
+    QTest::addColumn<int>("numGroups");
+    QTest::addColumn<int>("batchSize");
+
+    QTest::newRow("pairs") << 100 << 0 << 0 << 2;
+    QTest::newRow("batches of 4") << 100 << 0 << 0 << 4;
+    QTest::newRow("batches of 6") << 100 << 0 << 0 << MAX_BATCH_SIZE;
+    QTest::newRow("insertion in pairs") << 120 << 100 << 0 << 2;
+    QTest::newRow("insertion in batches of 4") << 120 << 100 << 0 << 4;
+    QTest::newRow("groups in pairs") << 100 << 0 << 7 << 2;
+    QTest::newRow("groups in batches of 3") << 100 << 0 << 7 << 3;
+}
+
+/**
+ * @brief Writes a list of items as text.
+ * @param aItems The items.
+ * @return The items, separated by commas.
+ */
+QString RankingEngineTests::describeItems(const QVector<int>& aItems)
+{
+    QStringList items;
+    for(int item : aItems)
+    {
+        items.append(QString::number(item));
+    }
+    return items.join(",");
+}
+
+/**
+ * @brief Writes everything that can be seen of an engine's state as text, so that two states can be compared.
+ * @param aEngine The engine.
+ * @return The number of interactions, the bounds on the remaining interactions, the frontier, the partial
+ * order, the upcoming items and the ranking.
+ */
+QString RankingEngineTests::describeState(const RankingEngine& aEngine)
+{
+    int lowerBound = 0;
+    int upperBound = 0;
+    aEngine.getRemainingInteractions(&lowerBound, &upperBound);
+    QString state = QString("interactions: %1, remaining: %2 to %3, frontier:").arg(aEngine.getNumInteractions()).arg(lowerBound).arg(upperBound);
+    for(const RankingEngine::comparison_group& group : aEngine.getFrontier())
+    {
+        state += QString(" %1[%2]").arg(group.task_id).arg(describeItems(group.items));
+    }
+    state += ", partial order:";
+    for(const QVector<int>& chain : aEngine.getPartialOrder())
+    {
+        state += QString(" [%1]").arg(describeItems(chain));
+    }
+    state += QString(", upcoming: [%1], ranking: [%2]").arg(describeItems(aEngine.getUpcomingItems())).arg(describeItems(aEngine.getRanking()));
+    return state;
+}
+
+/**
+ * @brief Gets the group that an item is sorted in.
+ * @param aItem The item.
+ * @param aNumGroups The number of groups.
+ * @return The index of the group. The last group gets more items than the others, so that the groups aren't all the same size.
+ */
+int RankingEngineTests::getGroup(int aItem, int aNumGroups)
+{
+    return std::min(aItem % (aNumGroups + 2), aNumGroups - 1);
+}
+
+/**
+ * @brief Makes up how much the scripted user likes each item.
+ * @param aNumItems The number of items.
+ * @return A different score for each item, in an order that is shuffled the same way every run.
+ */
+QVector<int> RankingEngineTests::getScores(int aNumItems)
+{
+    QVector<int> scores(aNumItems);
+    std::iota(scores.begin(), scores.end(), 0);
+    std::shuffle(scores.begin(), scores.end(), std::mt19937(SCORE_SEED));
+    return scores;
+}
+
+/**
+ * @brief Orders items the way the scripted user does.
+ * @param aItems The items.
+ * @param aScores The score of every item.
+ * @return The items, highest score first.
+ */
+QVector<int> RankingEngineTests::orderItems(const QVector<int>& aItems, const QVector<int>& aScores)
+{
+    QVector<int> orderedItems = aItems;
+    std::sort(orderedItems.begin(), orderedItems.end(), [&](int aFirst, int aSecond)
+    {
+        return aScores[aFirst] > aScores[aSecond];
+    });
+    return orderedItems;
+}
+
+/**
+ * @brief Starts a sort.
+ * @param aEngine The engine that sorts.
+ * @param aScores The score of every item.
+ * @param aNumRanked If not 0, the first items are already ranked and the rest are inserted into their ranking.
+ * @param aNumGroups If not 0, the items are split into this many @link RankingEngineTests::getGroup groups@endlink,
+ * which are sorted before they're merged.
+ * @param aBatchSize The most items that are shown at once.
+ */
+void RankingEngineTests::startSort(RankingEngine* aEngine, const QVector<int>& aScores, int aNumRanked, int aNumGroups, int aBatchSize)
+{
+    if(aNumRanked > 0)
+    {
+        QVector<int> rankedItems(aNumRanked);
+        std::iota(rankedItems.begin(), rankedItems.end(), 0);
+        aEngine->resetWithRanking(orderItems(rankedItems, aScores), aScores.count(), aBatchSize);
+    }
+    else if(aNumGroups > 0)
+    {
+        QList<QVector<int>> groups;
+        for(int i = 0; i < aNumGroups; i++)
+        {
+            groups.append(QVector<int>());
+        }
+        for(int item = 0; item < aScores.count(); item++)
+        {
+            groups[getGroup(item, aNumGroups)].append(item);
+        }
+        aEngine->resetWithGroups(groups, aScores.count(), aBatchSize);
+    }
+    else
+    {
+        aEngine->reset(aScores.count(), aBatchSize);
+    }
+}
+
+QTEST_APPLESS_MAIN(RankingEngineTests)
+
+#include "rankingenginetests.moc"
@@ -0,0 +1,11 @@
+#-------------------------------------------------
+#
+# The test suites. "make check" runs all of them.
+#
+#-------------------------------------------------
+
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    performance \
+    rankingengine